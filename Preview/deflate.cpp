@@ -0,0 +1,319 @@
+#include "deflate.h"
+#include <algorithm>
+#include <queue>
+
+#define WINDOW_SIZE 32768
+#define HASH_BITS 15
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+#define MAX_CHAIN 32
+
+#define LITLEN_CODES 286
+#define DIST_CODES 30
+#define CODELEN_CODES 19
+#define MAX_CODE_BITS 15
+#define MAX_CODELEN_BITS 7
+#define END_OF_BLOCK 256
+
+
+static const uint16_t lengthBase[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distBase[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distExtra[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const uint8_t codeLengthOrder[CODELEN_CODES] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+static int getLengthCode(int length) {
+    int code = 28;
+    while (lengthBase[code] > length) code--;
+    return code;
+}
+
+static int getDistCode(int distance) {
+    int code = 29;
+    while (distBase[code] > distance) code--;
+    return code;
+}
+
+//Длины кодов Хаффмана по частотам, не длиннее maxBits. Используется хотя бы два символа,
+//чтобы код всегда был полным
+static void buildLengths(std::vector<uint32_t> frequencies, int maxBits, std::vector<uint8_t>& lengths) {
+    size_t count = frequencies.size();
+    lengths.assign(count, 0);
+
+    std::vector<int> symbols;
+    for (size_t i = 0; i < count; i++) {
+        if (frequencies[i] > 0) symbols.push_back((int) i);
+    }
+    for (size_t i = 0; symbols.size() < 2 && i < count; i++) {
+        if (frequencies[i] == 0) {
+            frequencies[i] = 1;
+            symbols.push_back((int) i);
+        }
+    }
+
+    //Дерево Хаффмана: листья 0..n-1, внутренние узлы дальше
+    size_t n = symbols.size();
+    std::vector<int> parent(2 * n - 1, -1);
+    typedef std::pair<uint64_t, int> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    for (size_t i = 0; i < n; i++) queue.push({frequencies[symbols[i]], (int) i});
+
+    int next = (int) n;
+    while (queue.size() > 1) {
+        Item a = queue.top();
+        queue.pop();
+        Item b = queue.top();
+        queue.pop();
+
+        parent[a.second] = next;
+        parent[b.second] = next;
+        queue.push({a.first + b.first, next++});
+    }
+
+    //Число кодов каждой длины; слишком длинные укорачиваются с сохранением неравенства Крафта
+    std::vector<int> depth(2 * n - 1, 0);
+    std::vector<int> lengthCount(64, 0);
+    for (int node = next - 2; node >= 0; node--) depth[node] = depth[parent[node]] + 1;
+    for (size_t i = 0; i < n; i++) lengthCount[std::min(depth[i], 63)]++;
+
+    for (int bits = maxBits + 1; bits < 64; bits++) {
+        lengthCount[maxBits] += lengthCount[bits];
+        lengthCount[bits] = 0;
+    }
+
+    uint64_t total = 0;
+    for (int bits = 1; bits <= maxBits; bits++) total += (uint64_t) lengthCount[bits] << (maxBits - bits);
+    while (total > (1ull << maxBits)) {
+        lengthCount[maxBits]--;
+        for (int bits = maxBits - 1; bits > 0; bits--) {
+            if (lengthCount[bits] == 0) continue;
+            lengthCount[bits]--;
+            lengthCount[bits + 1] += 2;
+            break;
+        }
+        total--;
+    }
+
+    //Самые частые символы получают самые короткие коды
+    std::stable_sort(symbols.begin(), symbols.end(), [&frequencies](int a, int b) {
+        return frequencies[a] > frequencies[b];
+    });
+
+    size_t index = 0;
+    for (int bits = 1; bits <= maxBits; bits++) {
+        for (int i = 0; i < lengthCount[bits]; i++) lengths[symbols[index++]] = (uint8_t) bits;
+    }
+}
+
+//Канонические коды, уже развернутые для записи младшим битом вперед
+static void buildCodes(std::vector<uint8_t> const& lengths, std::vector<uint16_t>& codes) {
+    int lengthCount[MAX_CODE_BITS + 1] = {0};
+    for (uint8_t length: lengths) lengthCount[length]++;
+    lengthCount[0] = 0;
+
+    int nextCode[MAX_CODE_BITS + 1] = {0};
+    int code = 0;
+    for (int bits = 1; bits <= MAX_CODE_BITS; bits++) {
+        code = (code + lengthCount[bits - 1]) << 1;
+        nextCode[bits] = code;
+    }
+
+    codes.assign(lengths.size(), 0);
+    for (size_t i = 0; i < lengths.size(); i++) {
+        int length = lengths[i];
+        if (length == 0) continue;
+
+        int value = nextCode[length]++;
+        int reversed = 0;
+        for (int bit = 0; bit < length; bit++) reversed |= ((value >> bit) & 1) << (length - 1 - bit);
+        codes[i] = (uint16_t) reversed;
+    }
+}
+
+DeflateEncoder::DeflateEncoder() {
+    bitBuffer = 0;
+    bitCount = 0;
+}
+
+void DeflateEncoder::insert(size_t position) {
+    if (position + MIN_MATCH > window.size()) return;
+
+    uint32_t hash = ((uint32_t) window[position] << 16 | (uint32_t) window[position + 1] << 8 | window[position + 2]) * 2654435761u;
+    hash >>= 32 - HASH_BITS;
+
+    prev[position] = head[hash];
+    head[hash] = (int) position;
+}
+
+void DeflateEncoder::writeBits(std::string& out, uint32_t bits, int count) {
+    bitBuffer |= (uint64_t) bits << bitCount;
+    bitCount += count;
+
+    while (bitCount >= 8) {
+        out += (char) (bitBuffer & 0xff);
+        bitBuffer >>= 8;
+        bitCount -= 8;
+    }
+}
+
+void DeflateEncoder::compress(uint8_t const* data, size_t size, bool final, std::string& out) {
+    size_t history = window.size();
+    window.insert(window.end(), data, data + size);
+
+    head.assign(1 << HASH_BITS, -1);
+    prev.assign(window.size(), -1);
+    for (size_t i = 0; i < history; i++) insert(i);
+
+    tokens.clear();
+    size_t position = history;
+
+    while (position < window.size()) {
+        int bestLength = 0;
+        int bestDistance = 0;
+        int maxLength = (int) std::min((size_t) MAX_MATCH, window.size() - position);
+
+        if (maxLength >= MIN_MATCH) {
+            int candidate = -1;
+            uint32_t hash = ((uint32_t) window[position] << 16 | (uint32_t) window[position + 1] << 8 | window[position + 2]) * 2654435761u;
+            candidate = head[hash >> (32 - HASH_BITS)];
+
+            for (int chain = 0; candidate >= 0 && chain < MAX_CHAIN && position - candidate <= WINDOW_SIZE; chain++) {
+                uint8_t const* a = window.data() + candidate;
+                uint8_t const* b = window.data() + position;
+
+                if (a[bestLength] == b[bestLength]) {
+                    int length = 0;
+                    while (length < maxLength && a[length] == b[length]) length++;
+
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestDistance = (int) (position - candidate);
+                        if (length == maxLength) break;
+                    }
+                }
+                candidate = prev[candidate];
+            }
+        }
+
+        if (bestLength >= MIN_MATCH) {
+            tokens.push_back({(uint16_t) bestLength, (uint16_t) bestDistance});
+            for (int i = 0; i < bestLength; i++) insert(position + i);
+            position += bestLength;
+        } else {
+            tokens.push_back({window[position], 0});
+            insert(position);
+            position++;
+        }
+    }
+
+    writeBlock(out, final);
+
+    if (window.size() > WINDOW_SIZE) window.erase(window.begin(), window.end() - WINDOW_SIZE);
+    if (final && bitCount > 0) writeBits(out, 0, 8 - bitCount);
+}
+
+void DeflateEncoder::writeBlock(std::string& out, bool final) {
+    std::vector<uint32_t> litlenFrequencies(LITLEN_CODES, 0);
+    std::vector<uint32_t> distFrequencies(DIST_CODES, 0);
+
+    for (Token const& token: tokens) {
+        if (token.distance == 0) litlenFrequencies[token.value]++;
+        else {
+            litlenFrequencies[257 + getLengthCode(token.value)]++;
+            distFrequencies[getDistCode(token.distance)]++;
+        }
+    }
+    litlenFrequencies[END_OF_BLOCK]++;
+
+    std::vector<uint8_t> litlenLengths, distLengths;
+    std::vector<uint16_t> litlenCodes, distCodes;
+    buildLengths(litlenFrequencies, MAX_CODE_BITS, litlenLengths);
+    buildLengths(distFrequencies, MAX_CODE_BITS, distLengths);
+    buildCodes(litlenLengths, litlenCodes);
+    buildCodes(distLengths, distCodes);
+
+    int litlenCount = LITLEN_CODES;
+    while (litlenCount > 257 && litlenLengths[litlenCount - 1] == 0) litlenCount--;
+    int distCount = DIST_CODES;
+    while (distCount > 1 && distLengths[distCount - 1] == 0) distCount--;
+
+    //Длины обоих кодов подряд, сжатые повторами: 16 - повтор предыдущей, 17 и 18 - серии нулей
+    std::vector<uint8_t> allLengths(litlenLengths.begin(), litlenLengths.begin() + litlenCount);
+    allLengths.insert(allLengths.end(), distLengths.begin(), distLengths.begin() + distCount);
+
+    std::vector<std::pair<uint8_t, uint8_t>> codeLengthSymbols; //символ и значение дополнительных бит
+    std::vector<uint32_t> codeLengthFrequencies(CODELEN_CODES, 0);
+
+    for (size_t i = 0; i < allLengths.size();) {
+        uint8_t length = allLengths[i];
+        size_t run = 1;
+        while (i + run < allLengths.size() && allLengths[i + run] == length) run++;
+
+        if (length == 0 && run >= 3) {
+            size_t used = std::min(run, (size_t) 138);
+            if (used >= 11) codeLengthSymbols.push_back({18, (uint8_t) (used - 11)});
+            else codeLengthSymbols.push_back({17, (uint8_t) (used - 3)});
+            i += used;
+        } else if (length != 0 && run >= 4) {
+            size_t used = std::min(run - 1, (size_t) 6);
+            codeLengthSymbols.push_back({length, 0});
+            codeLengthSymbols.push_back({16, (uint8_t) (used - 3)});
+            i += used + 1;
+        } else {
+            codeLengthSymbols.push_back({length, 0});
+            i++;
+        }
+    }
+    for (auto& symbol: codeLengthSymbols) codeLengthFrequencies[symbol.first]++;
+
+    std::vector<uint8_t> codeLengthLengths;
+    std::vector<uint16_t> codeLengthCodes;
+    buildLengths(codeLengthFrequencies, MAX_CODELEN_BITS, codeLengthLengths);
+    buildCodes(codeLengthLengths, codeLengthCodes);
+
+    int codeLengthCount = CODELEN_CODES;
+    while (codeLengthCount > 4 && codeLengthLengths[codeLengthOrder[codeLengthCount - 1]] == 0) codeLengthCount--;
+
+    writeBits(out, final? 1 : 0, 1);
+    writeBits(out, 2, 2); //динамические коды
+    writeBits(out, litlenCount - 257, 5);
+    writeBits(out, distCount - 1, 5);
+    writeBits(out, codeLengthCount - 4, 4);
+    for (int i = 0; i < codeLengthCount; i++) writeBits(out, codeLengthLengths[codeLengthOrder[i]], 3);
+
+    for (auto& symbol: codeLengthSymbols) {
+        writeBits(out, codeLengthCodes[symbol.first], codeLengthLengths[symbol.first]);
+        if (symbol.first == 16) writeBits(out, symbol.second, 2);
+        else if (symbol.first == 17) writeBits(out, symbol.second, 3);
+        else if (symbol.first == 18) writeBits(out, symbol.second, 7);
+    }
+
+    for (Token const& token: tokens) {
+        if (token.distance == 0) {
+            writeBits(out, litlenCodes[token.value], litlenLengths[token.value]);
+            continue;
+        }
+
+        int lengthCode = getLengthCode(token.value);
+        writeBits(out, litlenCodes[257 + lengthCode], litlenLengths[257 + lengthCode]);
+        writeBits(out, token.value - lengthBase[lengthCode], lengthExtra[lengthCode]);
+
+        int distCode = getDistCode(token.distance);
+        writeBits(out, distCodes[distCode], distLengths[distCode]);
+        writeBits(out, token.distance - distBase[distCode], distExtra[distCode]);
+    }
+
+    writeBits(out, litlenCodes[END_OF_BLOCK], litlenLengths[END_OF_BLOCK]);
+}
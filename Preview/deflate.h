@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+//Сжатие deflate (RFC 1951) без внешних зависимостей: LZ77 по хеш-цепочкам в окне 32 КБ
+//и динамические коды Хаффмана. Каждый вызов compress пишет один блок, окно сохраняется между
+//вызовами, поэтому поток можно сжимать по частям, не держа его в памяти целиком
+class DeflateEncoder {
+private:
+    struct Token {
+        uint16_t value; //литерал или длина совпадения
+        uint16_t distance; //0 - литерал
+    };
+
+    std::vector<uint8_t> window;
+    std::vector<int> head;
+    std::vector<int> prev;
+    std::vector<Token> tokens;
+    uint64_t bitBuffer;
+    int bitCount;
+
+    void insert(size_t position);
+
+    void writeBits(std::string& out, uint32_t bits, int count);
+
+    void writeBlock(std::string& out, bool final);
+
+public:
+    DeflateEncoder();
+
+    //Сжимает size байт data в out. final - последний блок, после него поток выравнивается до байта
+    void compress(uint8_t const* data, size_t size, bool final, std::string& out);
+};
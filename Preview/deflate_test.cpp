@@ -0,0 +1,362 @@
+#include "deflate.h"
+#include "png_writer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <iterator>
+
+//Проверка DeflateEncoder и PngWriter: сжатые данные распаковываются независимым декодером (RFC 1951)
+//и сравниваются с исходными, у PNG дополнительно проверяются CRC чанков и Adler-32 потока zlib
+
+
+class Inflater {
+private:
+    struct Huffman {
+        short counts[16];
+        std::vector<short> symbols;
+    };
+
+    uint8_t const* data;
+    size_t size;
+    size_t position;
+    uint32_t bitBuffer;
+    int bitCount;
+
+    int bits(int count) {
+        while (bitCount < count) {
+            if (position >= size) throw std::runtime_error("unexpected end of stream");
+            bitBuffer |= (uint32_t) data[position++] << bitCount;
+            bitCount += 8;
+        }
+        int value = (int) (bitBuffer & ((1u << count) - 1));
+        bitBuffer >>= count;
+        bitCount -= count;
+        return value;
+    }
+
+    static void build(Huffman& huffman, uint8_t const* lengths, int count) {
+        std::memset(huffman.counts, 0, sizeof(huffman.counts));
+        for (int i = 0; i < count; i++) huffman.counts[lengths[i]]++;
+        huffman.counts[0] = 0;
+
+        int left = 1;
+        for (int length = 1; length < 16; length++) {
+            left = (left << 1) - huffman.counts[length];
+            if (left < 0) throw std::runtime_error("oversubscribed Huffman code");
+        }
+
+        short offsets[16];
+        offsets[1] = 0;
+        for (int length = 1; length < 15; length++) offsets[length + 1] = (short) (offsets[length] + huffman.counts[length]);
+
+        huffman.symbols.assign(count, 0);
+        for (int i = 0; i < count; i++) {
+            if (lengths[i] != 0) huffman.symbols[offsets[lengths[i]]++] = (short) i;
+        }
+    }
+
+    int decode(Huffman const& huffman) {
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int length = 1; length < 16; length++) {
+            code |= bits(1);
+            int count = huffman.counts[length];
+            if (code - count < first) return huffman.symbols[index + (code - first)];
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        throw std::runtime_error("invalid Huffman code");
+    }
+
+    void codes(std::vector<uint8_t>& out, Huffman const& literals, Huffman const& distances) {
+        static const short lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                             35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const short lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                              3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const short distBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                           257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static const short distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        while (true) {
+            int symbol = decode(literals);
+            if (symbol < 256) out.push_back((uint8_t) symbol);
+            else if (symbol == 256) return;
+            else {
+                symbol -= 257;
+                if (symbol >= 29) throw std::runtime_error("invalid length code");
+                int length = lengthBase[symbol] + bits(lengthExtra[symbol]);
+
+                symbol = decode(distances);
+                if (symbol >= 30) throw std::runtime_error("invalid distance code");
+                size_t distance = (size_t) (distBase[symbol] + bits(distExtra[symbol]));
+                if (distance > out.size()) throw std::runtime_error("distance too far back");
+
+                for (int i = 0; i < length; i++) out.push_back(out[out.size() - distance]);
+            }
+        }
+    }
+
+public:
+    Inflater(uint8_t const* data, size_t size) {
+        this->data = data;
+        this->size = size;
+        position = 0;
+        bitBuffer = 0;
+        bitCount = 0;
+    }
+
+    //Байты после конца потока deflate (например Adler-32 zlib)
+    size_t getPosition() const {
+        return position;
+    }
+
+    void inflate(std::vector<uint8_t>& out) {
+        static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        bool last;
+        do {
+            last = bits(1) == 1;
+            int type = bits(2);
+
+            if (type == 0) {
+                bitBuffer = 0;
+                bitCount = 0;
+                if (position + 4 > size) throw std::runtime_error("truncated stored block");
+                int length = data[position] | (data[position + 1] << 8);
+                int inverse = data[position + 2] | (data[position + 3] << 8);
+                if ((length ^ 0xffff) != inverse) throw std::runtime_error("stored block length mismatch");
+                position += 4;
+                if (position + length > size) throw std::runtime_error("truncated stored block");
+                out.insert(out.end(), data + position, data + position + length);
+                position += length;
+            } else if (type == 1) {
+                uint8_t lengths[288 + 30];
+                for (int i = 0; i < 144; i++) lengths[i] = 8;
+                for (int i = 144; i < 256; i++) lengths[i] = 9;
+                for (int i = 256; i < 280; i++) lengths[i] = 7;
+                for (int i = 280; i < 288; i++) lengths[i] = 8;
+                for (int i = 0; i < 30; i++) lengths[288 + i] = 5;
+
+                Huffman literals, distances;
+                build(literals, lengths, 288);
+                build(distances, lengths + 288, 30);
+                codes(out, literals, distances);
+            } else if (type == 2) {
+                int literalCount = bits(5) + 257;
+                int distanceCount = bits(5) + 1;
+                int codeLengthCount = bits(4) + 4;
+                if (literalCount > 286 || distanceCount > 30) throw std::runtime_error("too many codes");
+
+                uint8_t lengths[286 + 30] = {};
+                for (int i = 0; i < codeLengthCount; i++) lengths[order[i]] = (uint8_t) bits(3);
+                Huffman codeLengths;
+                build(codeLengths, lengths, 19);
+                std::memset(lengths, 0, sizeof(lengths));
+
+                int index = 0;
+                while (index < literalCount + distanceCount) {
+                    int symbol = decode(codeLengths);
+                    if (symbol < 16) {
+                        lengths[index++] = (uint8_t) symbol;
+                        continue;
+                    }
+
+                    uint8_t value = 0;
+                    int repeat;
+                    if (symbol == 16) {
+                        if (index == 0) throw std::runtime_error("repeat without previous length");
+                        value = lengths[index - 1];
+                        repeat = 3 + bits(2);
+                    } else if (symbol == 17) repeat = 3 + bits(3);
+                    else repeat = 11 + bits(7);
+
+                    if (index + repeat > literalCount + distanceCount) throw std::runtime_error("too many lengths");
+                    while (repeat-- > 0) lengths[index++] = value;
+                }
+                if (lengths[256] == 0) throw std::runtime_error("no end-of-block code");
+
+                Huffman literals, distances;
+                build(literals, lengths, literalCount);
+                build(distances, lengths + literalCount, distanceCount);
+                codes(out, literals, distances);
+            } else throw std::runtime_error("invalid block type");
+        } while (!last);
+    }
+};
+
+static uint32_t adler32(uint8_t const* data, size_t size) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < size; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+static uint32_t readBigEndian(uint8_t const* data) {
+    return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) | ((uint32_t) data[2] << 8) | data[3];
+}
+
+static int failures = 0;
+
+static void check(bool condition, char const* name, char const* what) {
+    if (condition) return;
+    std::printf("FAIL %s: %s\n", name, what);
+    failures++;
+}
+
+//Сжатие по частям partSize байт, как в PngWriter
+static void roundTrip(char const* name, std::vector<uint8_t> const& input, size_t partSize) {
+    DeflateEncoder encoder;
+    std::string compressed;
+
+    size_t offset = 0;
+    do {
+        size_t length = std::min(input.size() - offset, partSize);
+        encoder.compress(input.data() + offset, length, offset + length == input.size(), compressed);
+        offset += length;
+    } while (offset < input.size());
+
+    std::vector<uint8_t> output;
+    try {
+        Inflater inflater((uint8_t const*) compressed.data(), compressed.size());
+        inflater.inflate(output);
+        check(inflater.getPosition() == compressed.size(), name, "trailing bytes after final block");
+    } catch (std::exception const& error) {
+        check(false, name, error.what());
+        return;
+    }
+
+    check(output == input, name, "decompressed data differs");
+    std::printf("%s: %zu -> %zu bytes\n", name, input.size(), compressed.size());
+}
+
+static void pngRoundTrip() {
+    char const* path = "deflate_test.png";
+    int width = 300;
+    int height = 200;
+    std::vector<std::array<uint8_t, 3>> palette = {{0, 0, 0}, {255, 0, 0}, {0, 255, 0}, {0, 0, 255}};
+
+    std::vector<uint8_t> pixels((size_t) width * height);
+    std::mt19937 random(7);
+    for (size_t i = 0; i < pixels.size(); i++) pixels[i] = (uint8_t) ((i / 37 + (random() % 8 == 0)) % palette.size());
+
+    {
+        PngWriter writer(path, width, height, palette);
+        for (int row = 0; row < height; row += 16) writer.writeRows(pixels.data() + (size_t) row * width, std::min(16, height - row));
+        writer.finish();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> png((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path);
+
+    check(png.size() > 8 && std::memcmp(png.data(), "\x89PNG\r\n\x1a\n", 8) == 0, "png", "bad signature");
+
+    uint32_t crcTable[256];
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1)? 0xedb88320u ^ (c >> 1) : c >> 1;
+        crcTable[n] = c;
+    }
+
+    std::vector<uint8_t> zlib;
+    for (size_t position = 8; position + 12 <= png.size();) {
+        uint32_t length = readBigEndian(png.data() + position);
+        if (position + 12 + length > png.size()) {
+            check(false, "png", "truncated chunk");
+            return;
+        }
+
+        uint32_t crc = 0xffffffffu;
+        for (size_t i = position + 4; i < position + 8 + length; i++) crc = crcTable[(crc ^ png[i]) & 0xff] ^ (crc >> 8);
+        check((crc ^ 0xffffffffu) == readBigEndian(png.data() + position + 8 + length), "png", "chunk CRC mismatch");
+
+        if (std::memcmp(png.data() + position + 4, "IDAT", 4) == 0) {
+            zlib.insert(zlib.end(), png.begin() + position + 8, png.begin() + position + 8 + length);
+        }
+        position += 12 + length;
+    }
+
+    check(zlib.size() > 6 && zlib[0] == 0x78 && (zlib[0] * 256 + zlib[1]) % 31 == 0, "png", "bad zlib header");
+
+    std::vector<uint8_t> raw;
+    try {
+        Inflater inflater(zlib.data() + 2, zlib.size() - 2);
+        inflater.inflate(raw);
+        check(inflater.getPosition() + 4 == zlib.size() - 2, "png", "zlib stream is not followed by Adler-32 only");
+        check(readBigEndian(zlib.data() + zlib.size() - 4) == adler32(raw.data(), raw.size()), "png", "Adler-32 mismatch");
+    } catch (std::exception const& error) {
+        check(false, "png", error.what());
+        return;
+    }
+
+    std::vector<uint8_t> expected;
+    for (int row = 0; row < height; row++) {
+        expected.push_back(0);
+        expected.insert(expected.end(), pixels.begin() + (size_t) row * width, pixels.begin() + (size_t) (row + 1) * width);
+    }
+    check(raw == expected, "png", "scanlines differ");
+    std::printf("png: %zu bytes\n", png.size());
+}
+
+int main() {
+    std::mt19937 random(12345);
+
+    std::vector<uint8_t> randomBytes(300000);
+    for (auto& value: randomBytes) value = (uint8_t) random();
+
+    std::vector<uint8_t> constant(100000, 42);
+
+    //Несколько частых символов и редкие выбросы
+    std::vector<uint8_t> skewed(200000);
+    for (auto& value: skewed) value = (uint8_t) (random() % 16 == 0? random() : random() % 4);
+
+    //Частоты символов 0..24 по Фибоначчи - дерево Хаффмана глубже 15, проверка ограничения длины кода.
+    //После каждого символа три цифры счетчика из байтов 200..255, чтобы LZ77 почти не находил совпадений
+    std::vector<uint8_t> fibonacciSymbols;
+    uint32_t previous = 1, current = 1;
+    for (int symbol = 0; symbol < 25; symbol++) {
+        fibonacciSymbols.insert(fibonacciSymbols.end(), current, (uint8_t) symbol);
+        uint32_t next = previous + current;
+        previous = current;
+        current = next;
+    }
+    std::shuffle(fibonacciSymbols.begin(), fibonacciSymbols.end(), random);
+
+    std::vector<uint8_t> fibonacci;
+    for (size_t i = 0; i < fibonacciSymbols.size(); i++) {
+        fibonacci.push_back(fibonacciSymbols[i]);
+        fibonacci.push_back((uint8_t) (200 + i % 56));
+        fibonacci.push_back((uint8_t) (200 + i / 56 % 56));
+        fibonacci.push_back((uint8_t) (200 + i / 3136 % 56));
+    }
+
+    //Повторы на границе окна 32 КБ
+    std::vector<uint8_t> farRepeats(32768);
+    for (auto& value: farRepeats) value = (uint8_t) random();
+    for (int i = 0; i < 3; i++) farRepeats.insert(farRepeats.end(), farRepeats.begin(), farRepeats.begin() + 32768);
+
+    roundTrip("empty", {}, 1 << 18);
+    roundTrip("one byte", {7}, 1 << 18);
+    roundTrip("random", randomBytes, 1 << 18);
+    roundTrip("constant", constant, 1 << 18);
+    roundTrip("skewed", skewed, 1 << 18);
+    roundTrip("fibonacci", fibonacci, 1 << 18);
+    roundTrip("far repeats", farRepeats, 1 << 18);
+    roundTrip("small parts", skewed, 1000);
+    pngRoundTrip();
+
+    if (failures > 0) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include "custom_terrain.h"
+#include "png_writer.h"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+//Утилита для настройки генератора без сервера: рисует карту высот и воды сверху
+//по той же логике CustomTerrain, что использует CustomGenerator::generateChunk
+
+#define WATER_COLORS 64
+#define LAND_COLORS 192
+
+
+struct PreviewOptions {
+    std::string output;
+    int seed = 0;
+    int originX = 0;
+    int originZ = 0;
+    int size = 4096;
+    int scale = 1;
+    int tile = 256;
+    int threads = (int) std::thread::hardware_concurrency();
+};
+
+static std::array<uint8_t, 3> mix(std::array<uint8_t, 3> const& a, std::array<uint8_t, 3> const& b, float t) {
+    return {
+            (uint8_t) (a[0] + (b[0] - a[0]) * t),
+            (uint8_t) (a[1] + (b[1] - a[1]) * t),
+            (uint8_t) (a[2] + (b[2] - a[2]) * t)
+    };
+}
+
+//0..63 - глубина воды, 64..255 - высота суши над уровнем воды
+static std::vector<std::array<uint8_t, 3>> createPalette() {
+    std::vector<std::array<uint8_t, 3>> palette;
+
+    for (int i = 0; i < WATER_COLORS; i++) {
+        palette.push_back(mix({70, 130, 225}, {10, 30, 90}, i / (float) (WATER_COLORS - 1)));
+    }
+
+    for (int i = 0; i < LAND_COLORS; i++) {
+        if (i < 64) palette.push_back(mix({110, 180, 70}, {60, 110, 40}, i / 63.0f));
+        else if (i < 128) palette.push_back(mix({60, 110, 40}, {130, 125, 120}, (i - 64) / 63.0f));
+        else palette.push_back(mix({130, 125, 120}, {245, 245, 250}, (i - 128) / 63.0f));
+    }
+
+    return palette;
+}
+
+static uint8_t getColorIndex(int height) {
+    if (CustomTerrain::isUnderWater(height)) {
+        int depth = WATER_LEVEL - height - 1;
+        return (uint8_t) (depth < WATER_COLORS - 1? depth : WATER_COLORS - 1);
+    }
+
+    int elevation = height - WATER_LEVEL;
+    return (uint8_t) (WATER_COLORS + (elevation < LAND_COLORS - 1? elevation : LAND_COLORS - 1));
+}
+
+static void printUsage() {
+    std::cout << "Usage: GeneratorPreview <output.png> [--seed N] [--x X] [--z Z] [--size BLOCKS]\n"
+                 "                        [--scale BLOCKS_PER_PIXEL] [--tile PIXELS] [--threads N]\n"
+                 "  --x, --z   center of the preview in blocks (default 0 0)\n"
+                 "  --size     side of the previewed square in blocks (default 4096)\n";
+}
+
+static bool parseOptions(int argc, char** argv, PreviewOptions& options) {
+    if (argc < 2) return false;
+    options.output = argv[1];
+
+    for (int i = 2; i < argc; i += 2) {
+        if (i + 1 >= argc) return false;
+        int value = std::atoi(argv[i + 1]);
+
+        if (!strcmp(argv[i], "--seed")) options.seed = value;
+        else if (!strcmp(argv[i], "--x")) options.originX = value;
+        else if (!strcmp(argv[i], "--z")) options.originZ = value;
+        else if (!strcmp(argv[i], "--size")) options.size = value;
+        else if (!strcmp(argv[i], "--scale")) options.scale = value;
+        else if (!strcmp(argv[i], "--tile")) options.tile = value;
+        else if (!strcmp(argv[i], "--threads")) options.threads = value;
+        else return false;
+    }
+
+    if (options.threads < 1) options.threads = 1;
+    return options.size > 0 && options.scale > 0 && options.tile > 0 && options.size >= options.scale;
+}
+
+int main(int argc, char** argv) {
+    PreviewOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+
+    //Тот же порядок создания, что и в CustomGenerator: Random(seed), затем шум
+    GEN_API::Random random(options.seed);
+    CustomTerrain terrain(&random);
+
+    int pixels = options.size / options.scale;
+    int startX = options.originX - options.size / 2;
+    int startZ = options.originZ - options.size / 2;
+
+    PngWriter writer(options.output, pixels, pixels, createPalette());
+    if (!writer.isOpen()) {
+        std::cerr << "Cannot open " << options.output << "\n";
+        return 1;
+    }
+
+    //Изображение считается полосами высотой в один тайл, тайлы полосы делятся между потоками
+    int tilesPerRow = (pixels + options.tile - 1) / options.tile;
+    std::vector<uint8_t> band((size_t) pixels * options.tile);
+
+    for (int bandY = 0; bandY < pixels; bandY += options.tile) {
+        int bandHeight = std::min(options.tile, pixels - bandY);
+        std::atomic<int> nextTile(0);
+
+        auto renderTiles = [&]() {
+            std::vector<short> heights((size_t) options.tile * options.tile);
+
+            for (int tileIndex = nextTile++; tileIndex < tilesPerRow; tileIndex = nextTile++) {
+                int tileX = tileIndex * options.tile;
+                int tileWidth = std::min(options.tile, pixels - tileX);
+
+                terrain.getHeights(heights.data(),
+                                   startX + tileX * options.scale,
+                                   startZ + bandY * options.scale,
+                                   tileWidth, bandHeight, options.scale);
+
+                for (int dx = 0; dx < tileWidth; dx++) {
+                    for (int dz = 0; dz < bandHeight; dz++) {
+                        band[(size_t) dz * pixels + tileX + dx] = getColorIndex(heights[dx * bandHeight + dz]);
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int i = 1; i < options.threads; i++) workers.emplace_back(renderTiles);
+        renderTiles();
+        for (auto& worker: workers) worker.join();
+
+        writer.writeRows(band.data(), bandHeight);
+    }
+
+    writer.finish();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::cout << "Rendered " << pixels << "x" << pixels << " px (" << options.size << " blocks, scale "
+              << options.scale << ") with " << options.threads << " threads in " << seconds << " s -> "
+              << options.output << "\n";
+    return 0;
+}
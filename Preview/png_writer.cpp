@@ -0,0 +1,121 @@
+#include "png_writer.h"
+#include <algorithm>
+
+#define ADLER_MOD 65521
+#define ADLER_NMAX 5552
+#define DEFLATE_BLOCK_SIZE (1 << 18)
+#define IDAT_CHUNK_SIZE (1 << 20)
+
+
+static uint32_t crcTable[256];
+
+static void initCrcTable() {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1)? 0xedb88320u ^ (c >> 1) : c >> 1;
+        crcTable[n] = c;
+    }
+}
+
+static void appendBigEndian(std::string& out, uint32_t value) {
+    out += (char) (value >> 24);
+    out += (char) (value >> 16);
+    out += (char) (value >> 8);
+    out += (char) value;
+}
+
+PngWriter::PngWriter(std::string const& path, int width, int height, std::vector<std::array<uint8_t, 3>> const& palette) {
+    if (crcTable[1] == 0) initCrcTable();
+
+    this->width = width;
+    adlerA = 1;
+    adlerB = 0;
+
+    out.open(path, std::ios::binary | std::ios::trunc);
+    out.write("\x89PNG\r\n\x1a\n", 8);
+
+    std::string header;
+    appendBigEndian(header, (uint32_t) width);
+    appendBigEndian(header, (uint32_t) height);
+    header += (char) 8; //бит на индекс
+    header += (char) 3; //палитра
+    header += (char) 0;
+    header += (char) 0;
+    header += (char) 0;
+    writeChunk("IHDR", header);
+
+    std::string colors;
+    for (auto& color: palette) colors.append((char const*) color.data(), 3);
+    writeChunk("PLTE", colors);
+
+    //Заголовок zlib: deflate, окно 32 КБ, без словаря
+    idat += (char) 0x78;
+    idat += (char) 0x9c;
+}
+
+void PngWriter::writeChunk(char const* type, std::string const& data) {
+    std::string chunk(type, 4);
+    chunk += data;
+
+    uint32_t crc = 0xffffffffu;
+    for (unsigned char c: chunk) crc = crcTable[(crc ^ c) & 0xff] ^ (crc >> 8);
+
+    std::string length;
+    appendBigEndian(length, (uint32_t) data.size());
+    std::string tail;
+    appendBigEndian(tail, crc ^ 0xffffffffu);
+
+    out.write(length.data(), 4);
+    out.write(chunk.data(), (std::streamsize) chunk.size());
+    out.write(tail.data(), 4);
+}
+
+void PngWriter::flushBlocks(bool final) {
+    size_t offset = 0;
+
+    while (raw.size() - offset >= DEFLATE_BLOCK_SIZE || final) {
+        size_t length = std::min(raw.size() - offset, (size_t) DEFLATE_BLOCK_SIZE);
+        bool last = final && offset + length == raw.size();
+
+        encoder.compress((uint8_t const*) raw.data() + offset, length, last, idat);
+        offset += length;
+
+        if (idat.size() >= IDAT_CHUNK_SIZE) {
+            writeChunk("IDAT", idat);
+            idat.clear();
+        }
+        if (last) break;
+    }
+
+    raw.erase(0, offset);
+}
+
+void PngWriter::writeRows(uint8_t const* indices, int rows) {
+    for (int row = 0; row < rows; row++) {
+        size_t start = raw.size();
+        raw += (char) 0; //фильтр None
+        raw.append((char const*) indices + (size_t) row * width, width);
+
+        for (size_t i = start; i < raw.size();) {
+            size_t end = std::min(raw.size(), i + ADLER_NMAX);
+            for (; i < end; i++) {
+                adlerA += (unsigned char) raw[i];
+                adlerB += adlerA;
+            }
+            adlerA %= ADLER_MOD;
+            adlerB %= ADLER_MOD;
+        }
+    }
+
+    flushBlocks(false);
+}
+
+void PngWriter::finish() {
+    flushBlocks(true);
+    appendBigEndian(idat, (adlerB << 16) | adlerA);
+    writeChunk("IDAT", idat);
+    idat.clear();
+
+    writeChunk("IEND", "");
+    out.close();
+}
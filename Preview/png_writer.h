@@ -0,0 +1,37 @@
+#pragma once
+#include "deflate.h"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+
+//Потоковая запись PNG с палитрой (8 бит на пиксель) без внешних зависимостей.
+//Строки сжимаются DeflateEncoder по частям, поэтому изображение не нужно держать в памяти целиком
+class PngWriter {
+private:
+    std::ofstream out;
+    int width;
+    std::string raw;
+    std::string idat;
+    DeflateEncoder encoder;
+    uint32_t adlerA;
+    uint32_t adlerB;
+
+    void writeChunk(char const* type, std::string const& data);
+
+    void flushBlocks(bool final);
+
+public:
+    PngWriter(std::string const& path, int width, int height, std::vector<std::array<uint8_t, 3>> const& palette);
+
+    bool isOpen() const {
+        return out.is_open() && out.good();
+    }
+
+    //rows строк по width индексов палитры
+    void writeRows(uint8_t const* indices, int rows);
+
+    void finish();
+};
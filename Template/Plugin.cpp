@@ -1,12 +1,56 @@
 #include "pch.h"
 #include "generator/generator.h"
+#include "generator/snapshot_cache.h"
+#include "generator/batch_scheduler.h"
+#include "generator/prefetcher.h"
+
+//Кэш сгенерированных чанков для миров, которые часто сбрасываются с тем же сидом
+#define CHUNK_SNAPSHOT_CACHE false
+#define CHUNK_SNAPSHOT_PATH "plugins/CustomWorldGenerator/snapshots"
+
+//Пакетная генерация соседних чанков: 1 - суперчанки 2x2, 2 - 4x4
+#define BATCH_SUPERCHUNK_SHIFT 1
+//Окно, в котором запросы соседних чанков считаются одной группой
+#define BATCH_LATENCY_BUDGET_MS 50
+
+//Предварительная генерация чанков по направлению движения быстрых игроков. 0 потоков - выключено.
+//Готовый чанк занимает в памяти десятки КБ, PREFETCH_MAX_CHUNKS ограничивает их число
+#define PREFETCH_THREADS 0
+#define PREFETCH_MAX_CHUNKS 1024
+#define PREFETCH_LOOKAHEAD_TICKS 100
+#define PREFETCH_RADIUS 2
+#define PREFETCH_STATS_INTERVAL_TICKS 6000
 
 
 GEN_API::WorldGenerator* worldGenerator;
+GEN_API::ChunkSnapshotCache* snapshotCache = nullptr;
+GEN_API::BatchScheduler* batchScheduler;
+GEN_API::ChunkPrefetcher* prefetcher = nullptr;
+Logger logger("CustomWorldGenerator");
 
 void PluginInit() {
     worldGenerator = new CustomGenerator(0); //TODO: Сид мира
     std::filesystem::create_directories(Level::getCurrentLevelPath() + "/transactions");
+    batchScheduler = new GEN_API::BatchScheduler(worldGenerator, BATCH_SUPERCHUNK_SHIFT, BATCH_LATENCY_BUDGET_MS);
+
+    if (CHUNK_SNAPSHOT_CACHE) snapshotCache = new GEN_API::ChunkSnapshotCache(CHUNK_SNAPSHOT_PATH, worldGenerator);
+
+    if (PREFETCH_THREADS > 0) {
+        prefetcher = new GEN_API::ChunkPrefetcher(worldGenerator, PREFETCH_THREADS, PREFETCH_MAX_CHUNKS,
+                                                  PREFETCH_LOOKAHEAD_TICKS, PREFETCH_RADIUS);
+
+        Schedule::repeat([]() {
+            prefetcher->tick();
+        }, 1);
+
+        Schedule::repeat([]() {
+            unsigned long long hits = prefetcher->getHits();
+            unsigned long long misses = prefetcher->getMisses();
+            logger.info("Prefetch: {} hits, {} misses ({}% hit rate), {} evicted unused, {} failed in buffered mode",
+                        hits, misses, hits + misses > 0? hits * 100 / (hits + misses) : 0, prefetcher->getEvicted(),
+                        prefetcher->getFailed());
+        }, PREFETCH_STATS_INTERVAL_TICKS);
+    }
 }
 
 //Отмена стандартной генерации поверхностей
@@ -43,8 +87,16 @@ TClasslessInstanceHook(void, "?buildSurfaces@OverworldGenerator@@QEAAXAEAUThread
     int chunkX = chunkPos.x;
     int chunkZ = chunkPos.z;
 
-    worldGenerator->getRandom()->setSeed((int)(0xdeadbeef ^ (chunkX << 8) ^ chunkZ ^ worldGenerator->getSeed()));
-    worldGenerator->generateChunk(&chunkManager, chunkX, chunkZ);
+    if (snapshotCache == nullptr || !snapshotCache->replay(&chunkManager)) {
+        //Заранее сгенерированный чанк только копируется
+        if (prefetcher == nullptr || !prefetcher->take(&chunkManager)) {
+            GEN_API::ChunkColumns columns;
+            bool batched = batchScheduler->acquire(chunkX, chunkZ, columns);
+            worldGenerator->generate(&chunkManager, batched? &columns : nullptr);
+        }
+
+        if (snapshotCache != nullptr) snapshotCache->store(&chunkManager);
+    }
 
     levelChunk.markSaveIfNeverSaved();
 }
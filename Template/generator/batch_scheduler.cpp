@@ -0,0 +1,123 @@
+#include "batch_scheduler.h"
+#include <Windows.h>
+
+#define CHUNK_KEY(x, z) (((long long) (x) << 32) | (unsigned int) (z))
+//Столбцы, которые так и не запросили (например, чанк уже был на диске), удаляются по таймеру
+#define BATCH_READY_TTL std::chrono::seconds(5)
+#define BATCH_STATE_TTL std::chrono::seconds(30)
+#define BATCH_CLEANUP_INTERVAL std::chrono::seconds(1)
+
+
+GEN_API::BatchScheduler::BatchScheduler(WorldGenerator* generator, int superchunkShift, int latencyBudgetMs) {
+    this->generator = generator;
+    this->shift = superchunkShift < 1? 1 : (superchunkShift > 2? 2 : superchunkShift);
+    this->latencyBudget = std::chrono::milliseconds(latencyBudgetMs);
+
+    running = true;
+    worker = std::thread(&BatchScheduler::work, this);
+}
+
+GEN_API::BatchScheduler::~BatchScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    condition.notify_all();
+    worker.join();
+}
+
+void GEN_API::BatchScheduler::cleanup(std::chrono::steady_clock::time_point now) {
+    for (auto it = ready.begin(); it != ready.end();) {
+        if (now - it->second.created > BATCH_READY_TTL) it = ready.erase(it);
+        else ++it;
+    }
+
+    for (auto it = superchunks.begin(); it != superchunks.end();) {
+        if (!it->second.queued && now - it->second.lastRequest > BATCH_STATE_TTL) it = superchunks.erase(it);
+        else ++it;
+    }
+}
+
+bool GEN_API::BatchScheduler::acquire(int chunkX, int chunkZ, ChunkColumns& columns) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = ready.find(CHUNK_KEY(chunkX, chunkZ));
+    if (found != ready.end()) {
+        columns = found->second.columns;
+        ready.erase(found);
+        return true;
+    }
+
+    int superX = chunkX >> shift;
+    int superZ = chunkZ >> shift;
+    long long superKey = CHUNK_KEY(superX, superZ);
+
+    //Новая запись создается с нулевыми полями: requested = 0, queued = false
+    Superchunk& superchunk = superchunks[superKey];
+    bool batch = superchunk.requested != 0 && !superchunk.queued && now - superchunk.lastRequest <= latencyBudget;
+
+    superchunk.lastRequest = now;
+    superchunk.requested |= 1u << (((chunkX - (superX << shift)) << shift) | (chunkZ - (superZ << shift)));
+
+    if (batch) {
+        superchunk.queued = true;
+        queue.push_back(superKey);
+        condition.notify_one();
+    }
+    return false;
+}
+
+void GEN_API::BatchScheduler::work() {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+
+    int size = 1 << shift;
+    auto lastCleanup = std::chrono::steady_clock::now();
+    vector<ChunkPos> positions;
+    vector<ChunkColumns> result;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        condition.wait_for(lock, BATCH_CLEANUP_INTERVAL, [this] { return !running || !queue.empty(); });
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastCleanup >= BATCH_CLEANUP_INTERVAL) {
+            cleanup(now);
+            lastCleanup = now;
+        }
+        if (!running || queue.empty()) continue;
+
+        long long superKey = queue.front();
+        queue.pop_front();
+
+        int superX = (int) (superKey >> 32);
+        int superZ = (int) superKey;
+        unsigned int requested = superchunks[superKey].requested;
+
+        //Только чанки, которые еще никто не запрашивал
+        positions.clear();
+        for (int dx = 0; dx < size; dx++) {
+            for (int dz = 0; dz < size; dz++) {
+                if (requested & (1u << ((dx << shift) | dz))) continue;
+                positions.emplace_back((superX << shift) + dx, (superZ << shift) + dz);
+            }
+        }
+
+        lock.unlock();
+        bool generated = !positions.empty() && generator->generateBatch(positions, result) && result.size() == positions.size();
+        lock.lock();
+
+        Superchunk& state = superchunks[superKey];
+        state.queued = false;
+        if (!generated) continue;
+
+        //Чанки, запрошенные во время расчета, уже сгенерированы своими потоками
+        now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < positions.size(); i++) {
+            unsigned int bit = 1u << (((positions[i].x - (superX << shift)) << shift) | (positions[i].z - (superZ << shift)));
+            if (state.requested & bit) continue;
+            ready[CHUNK_KEY(positions[i].x, positions[i].z)] = {now, result[i]};
+        }
+        state.requested = (1u << (size * size)) - 1;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "pch.h"
+#include "generator_tools.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <deque>
+#include <unordered_map>
+
+
+namespace GEN_API {
+    //Группирует запросы соседних чанков в суперчанки (2x2 при shift = 1, 4x4 при shift = 2).
+    //Если в суперчанке уже был запрос в пределах latencyBudget, оставшиеся чанки суперчанка
+    //считаются одним generateBatch на фоновом потоке, а их запросы забирают готовый результат.
+    //Запрос никогда не ждет соседей: сам он всегда идет по обычному пути, если столбцы еще не готовы
+    class BatchScheduler {
+    private:
+        struct Superchunk {
+            std::chrono::steady_clock::time_point lastRequest;
+            unsigned int requested;
+            bool queued;
+        };
+
+        struct ReadyColumns {
+            std::chrono::steady_clock::time_point created;
+            ChunkColumns columns;
+        };
+
+        WorldGenerator* generator;
+        int shift;
+        std::chrono::milliseconds latencyBudget;
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::unordered_map<long long, Superchunk> superchunks;
+        std::unordered_map<long long, ReadyColumns> ready;
+        std::deque<long long> queue;
+        std::thread worker;
+        bool running;
+
+        void cleanup(std::chrono::steady_clock::time_point now);
+
+        void work();
+
+    public:
+        BatchScheduler(WorldGenerator* generator, int superchunkShift, int latencyBudgetMs);
+
+        ~BatchScheduler();
+
+        //true - столбцы чанка получены из пакетной генерации
+        bool acquire(int chunkX, int chunkZ, ChunkColumns& columns);
+    };
+}
@@ -0,0 +1,143 @@
+#include "block_registry.h"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <atomic>
+
+
+struct BlockRegistryEntry {
+    string name;
+    unsigned short tileData;
+    std::atomic<Block const*> block;
+    std::atomic<bool> missing; //Block::create уже вернул nullptr
+};
+
+typedef std::unordered_map<string, vector<std::pair<unsigned short, GEN_API::BlockHandle>>> HandlesByName;
+
+static std::shared_mutex registryMutex;
+static HandlesByName handlesByName;
+static std::unordered_map<Block const*, GEN_API::BlockHandle> handlesByBlock;
+//Записываются под registryMutex, читаются без блокировки
+static std::atomic<BlockRegistryEntry*> entries[BLOCK_HANDLE_INVALID];
+static unsigned int entryCount = 0;
+
+//Копия уже найденных handle для каждого потока, повторный intern по строке не берет общий мьютекс
+static thread_local HandlesByName localHandles;
+
+//Последние id для каждого потока: повторный intern того же id - сравнение строки без хеширования
+#define RECENT_IDS 8
+
+struct RecentId {
+    string name;
+    unsigned short tileData;
+    GEN_API::BlockHandle handle = BLOCK_HANDLE_INVALID;
+};
+
+static thread_local RecentId recentIds[RECENT_IDS];
+
+
+static GEN_API::BlockHandle findHandle(string const& blockId, unsigned short tileData) {
+    auto found = handlesByName.find(blockId);
+    if (found == handlesByName.end()) return BLOCK_HANDLE_INVALID;
+
+    for (auto& variant: found->second) {
+        if (variant.first == tileData) return variant.second;
+    }
+    return BLOCK_HANDLE_INVALID;
+}
+
+static BlockRegistryEntry* getEntry(GEN_API::BlockHandle handle) {
+    if (handle == BLOCK_HANDLE_INVALID) return nullptr;
+    return entries[handle].load(std::memory_order_acquire);
+}
+
+static GEN_API::BlockHandle internSlow(string const& blockId, unsigned short tileData) {
+    auto& localVariants = localHandles[blockId];
+    for (auto& variant: localVariants) {
+        if (variant.first == tileData) return variant.second;
+    }
+
+    GEN_API::BlockHandle handle = BLOCK_HANDLE_INVALID;
+    {
+        std::shared_lock<std::shared_mutex> lock(registryMutex);
+        handle = findHandle(blockId, tileData);
+    }
+
+    if (handle == BLOCK_HANDLE_INVALID) {
+        std::unique_lock<std::shared_mutex> lock(registryMutex);
+        handle = findHandle(blockId, tileData);
+
+        if (handle == BLOCK_HANDLE_INVALID) {
+            if (entryCount >= BLOCK_HANDLE_INVALID) return BLOCK_HANDLE_INVALID;
+
+            handle = (GEN_API::BlockHandle) entryCount;
+            entries[handle].store(new BlockRegistryEntry{blockId, tileData, {nullptr}, {false}}, std::memory_order_release);
+            handlesByName[blockId].emplace_back(tileData, handle);
+            entryCount++;
+        }
+    }
+
+    localVariants.emplace_back(tileData, handle);
+    return handle;
+}
+
+static RecentId& getRecentId(string const& blockId, unsigned short tileData) {
+    size_t size = blockId.size();
+    unsigned int last = size > 0? (unsigned char) blockId[size - 1] : 0;
+    return recentIds[(size ^ last ^ tileData) & (RECENT_IDS - 1)];
+}
+
+GEN_API::BlockHandle GEN_API::BlockRegistry::intern(string const& blockId, unsigned short tileData) {
+    RecentId& recent = getRecentId(blockId, tileData);
+    if (recent.handle != BLOCK_HANDLE_INVALID && recent.tileData == tileData && recent.name == blockId) return recent.handle;
+
+    BlockHandle handle = internSlow(blockId, tileData);
+    if (handle != BLOCK_HANDLE_INVALID) {
+        recent.name = blockId;
+        recent.tileData = tileData;
+        recent.handle = handle;
+    }
+    return handle;
+}
+
+GEN_API::BlockHandle GEN_API::BlockRegistry::intern(Block const* block) {
+    if (block == nullptr) return BLOCK_HANDLE_INVALID;
+    {
+        std::shared_lock<std::shared_mutex> lock(registryMutex);
+        auto found = handlesByBlock.find(block);
+        if (found != handlesByBlock.end()) return found->second;
+    }
+
+    //Handle разрешается через Block::create(id, tileData). Если получается другое состояние блока,
+    //пара его не выражает, и handle не выдается, чтобы не подменить блок
+    BlockHandle handle = intern(block->getTypeName(), const_cast<Block*>(block)->getTileData());
+    if (handle != BLOCK_HANDLE_INVALID && get(handle) != block) handle = BLOCK_HANDLE_INVALID;
+
+    std::unique_lock<std::shared_mutex> lock(registryMutex);
+    handlesByBlock[block] = handle;
+    return handle;
+}
+
+Block const* GEN_API::BlockRegistry::get(BlockHandle handle) {
+    BlockRegistryEntry* entry = getEntry(handle);
+    if (entry == nullptr) return nullptr;
+
+    Block const* block = entry->block.load(std::memory_order_acquire);
+    if (block == nullptr && !entry->missing.load(std::memory_order_acquire)) {
+        block = Block::create(entry->name, entry->tileData);
+        if (block != nullptr) entry->block.store(block, std::memory_order_release);
+        else entry->missing.store(true, std::memory_order_release);
+    }
+    return block;
+}
+
+string const& GEN_API::BlockRegistry::getName(BlockHandle handle) {
+    static const string empty;
+    BlockRegistryEntry* entry = getEntry(handle);
+    return entry != nullptr? entry->name : empty;
+}
+
+unsigned short GEN_API::BlockRegistry::getTileData(BlockHandle handle) {
+    BlockRegistryEntry* entry = getEntry(handle);
+    return entry != nullptr? entry->tileData : 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "pch.h"
+
+
+#define BLOCK_HANDLE_INVALID 0xFFFF
+
+
+namespace GEN_API {
+    //Компактный идентификатор пары (id блока, tileData), выдается BlockRegistry
+    typedef unsigned short BlockHandle;
+
+    //Потокобезопасный реестр интернированных блоков. Block const* разрешается один раз
+    //при первом обращении, поэтому handle можно получить еще до загрузки блоков сервера.
+    //Быстрый путь - BlockHandle, полученный заранее: get сводится к чтению из массива.
+    //intern по строке сравнивает id с недавними id потока и хеширует его только при промахе,
+    //но все равно медленнее handle и указателя, его место - конструкторы и загрузка данных
+    class BlockRegistry {
+    public:
+        static BlockHandle intern(string const& blockId, unsigned short tileData = 0);
+
+        //BLOCK_HANDLE_INVALID, если состояние блока не выражается парой (id, tileData),
+        //то есть get для нее вернул бы другой блок
+        static BlockHandle intern(Block const* block);
+
+        //nullptr, если handle неверный или блок с таким id не существует.
+        //Отсутствие блока запоминается, поэтому get нельзя вызывать до загрузки блоков сервера
+        static Block const* get(BlockHandle handle);
+
+        static string const& getName(BlockHandle handle);
+
+        static unsigned short getTileData(BlockHandle handle);
+    };
+}
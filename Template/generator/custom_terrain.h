@@ -0,0 +1,42 @@
+#pragma once
+#include "noise.h"
+
+
+#define WATER_LEVEL 60
+
+//Высота поверхности примера CustomGenerator. Не зависит от SDK, чтобы утилита Preview
+//рисовала карту по той же логике, что и generateChunk
+class CustomTerrain {
+private:
+    GEN_API::Simplex* simplex;
+
+public:
+    CustomTerrain(GEN_API::Random* random) {
+        simplex = new GEN_API::Simplex(random, 8, 1/32.0f, 1/64.0f);
+    }
+
+    ~CustomTerrain() {
+        delete simplex;
+    }
+
+    static int getSurfaceHeight(float noise) {
+        return (int) (noise * 8 + WATER_LEVEL);
+    }
+
+    static bool isUnderWater(int height) {
+        return height < WATER_LEVEL;
+    }
+
+    int getHeightAt(int x, int z) {
+        return simplex->noise2DQuantized((float) x, (float) z, [](float noise) {
+            return getSurfaceHeight(noise);
+        });
+    }
+
+    //Высоты для сетки width x depth точек с шагом step блоков, out[dx * depth + dz]
+    void getHeights(short* out, int startX, int startZ, int width, int depth, int step = 1) {
+        simplex->noise2DGridQuantized(out, startX, startZ, width, depth, [](float noise) {
+            return getSurfaceHeight(noise);
+        }, false, step);
+    }
+};
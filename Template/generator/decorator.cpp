@@ -0,0 +1,112 @@
+#include "decorator.h"
+#include <algorithm>
+
+
+static bool isHostBlock(Block const& current, Block const* host) {
+    if (host == nullptr) return true;
+    if (host == VanillaBlocks::mAir) return current.getId() == 0;
+    return &current == host;
+}
+
+void GEN_API::OreFeature::plan(Random* random, ChunkManager* world, int chunkX, int chunkZ, DecorationPlan& plan) {
+    Block const* oreBlock = BlockRegistry::get(ore);
+    Block const* hostBlock = BlockRegistry::get(host);
+    if (oreBlock == nullptr || hostBlock == nullptr) return;
+
+    for (int vein = 0; vein < veinsPerChunk; vein++) {
+        int x = C2G_COORD(chunkX) + random->nextInt(CHUNK_SIZE);
+        int y = random->nextInt(minY, maxY);
+        int z = C2G_COORD(chunkZ) + random->nextInt(CHUNK_SIZE);
+
+        for (int i = 0; i < veinSize; i++) {
+            plan.add(x, y, z, oreBlock, hostBlock);
+
+            switch (random->nextInt(6)) {
+                case 0: x++; break;
+                case 1: x--; break;
+                case 2: y++; break;
+                case 3: y--; break;
+                case 4: z++; break;
+                default: z--; break;
+            }
+        }
+    }
+}
+
+void GEN_API::ScatterFeature::plan(Random* random, ChunkManager* world, int chunkX, int chunkZ, DecorationPlan& plan) {
+    Block const* scatterBlock = BlockRegistry::get(block);
+    Block const* hostBlock = BlockRegistry::get(host);
+    if (scatterBlock == nullptr || hostBlock == nullptr) return;
+
+    for (int cluster = 0; cluster < clusters; cluster++) {
+        int cx = C2G_COORD(chunkX) + random->nextInt(CHUNK_SIZE);
+        int cy = random->nextInt(minY, maxY);
+        int cz = C2G_COORD(chunkZ) + random->nextInt(CHUNK_SIZE);
+
+        for (int i = 0; i < clusterSize; i++) {
+            plan.add(cx + random->nextInt(-spread, spread),
+                     cy + random->nextInt(-spread, spread),
+                     cz + random->nextInt(-spread, spread),
+                     scatterBlock, hostBlock);
+        }
+    }
+}
+
+void GEN_API::SurfacePlantFeature::plan(Random* random, ChunkManager* world, int chunkX, int chunkZ, DecorationPlan& plan) {
+    Block const* plantBlock = BlockRegistry::get(plant);
+    Block const* groundBlock = BlockRegistry::get(ground);
+    if (plantBlock == nullptr || groundBlock == nullptr) return;
+
+    for (int i = 0; i < count; i++) {
+        int x = C2G_COORD(chunkX) + random->nextInt(CHUNK_SIZE);
+        int z = C2G_COORD(chunkZ) + random->nextInt(CHUNK_SIZE);
+        int y = world->getHighestBlockAt(x, z);
+
+        if (&world->getBlockAt(x, y, z) != groundBlock) continue;
+        plan.add(x, y + 1, z, plantBlock, VanillaBlocks::mAir);
+    }
+}
+
+void GEN_API::Decorator::decorate(ChunkManager* world, int seed) {
+    int chunkX = world->getChunkPos()->x;
+    int chunkZ = world->getChunkPos()->z;
+
+    DecorationPlan plan;
+    for (size_t i = 0; i < features.size(); i++) {
+        Random random((int) (0xdeadbeef ^ (chunkX << 8) ^ chunkZ ^ seed ^ ((i + 1) * 0x9e3779b1)));
+        features[i]->plan(&random, world, chunkX, chunkZ, plan);
+    }
+
+    //Сначала блоки своего чанка по столбцам, затем чужие. При совпадении позиций порядок фич сохраняется
+    auto& placements = plan.getPlacements();
+    std::stable_sort(placements.begin(), placements.end(), [chunkX, chunkZ](BlockPlacement const& a, BlockPlacement const& b) {
+        bool aOutside = G2C_COORD(a.x) != chunkX || G2C_COORD(a.z) != chunkZ;
+        bool bOutside = G2C_COORD(b.x) != chunkX || G2C_COORD(b.z) != chunkZ;
+        if (aOutside != bOutside) return bOutside;
+        if (a.x != b.x) return a.x < b.x;
+        if (a.z != b.z) return a.z < b.z;
+        return a.y < b.y;
+    });
+
+    BlockTransaction transaction;
+    bool hasOutside = false;
+
+    for (BlockPlacement const& placement: placements) {
+        if (G2C_COORD(placement.x) != chunkX || G2C_COORD(placement.z) != chunkZ) {
+            if (placement.host == nullptr) {
+                transaction.addBlock(placement.x, placement.y, placement.z, placement.block, true);
+            } else if (placement.host == VanillaBlocks::mAir) {
+                transaction.addBlock(placement.x, placement.y, placement.z, placement.block, false);
+            } else {
+                transaction.addBlockReplacing(placement.x, placement.y, placement.z, placement.block, placement.host);
+            }
+            hasOutside = true;
+            continue;
+        }
+
+        if (!isHostBlock(world->getBlockAt(placement.x, placement.y, placement.z), placement.host)) continue;
+        world->setBlockAt(placement.x, placement.y, placement.z, placement.block);
+    }
+
+    if (hasOutside) transaction.apply(world);
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "pch.h"
+#include "generator_tools.h"
+
+
+namespace GEN_API {
+    struct BlockPlacement {
+        int x;
+        short y;
+        int z;
+        Block const* block;
+        Block const* host; //nullptr - заменяет любой блок, VanillaBlocks::mAir - только пустоту
+    };
+
+    class DecorationPlan {
+    private:
+        vector<BlockPlacement> placements;
+
+    public:
+        void add(int x, int y, int z, Block const* block, Block const* host) {
+            if (y < WORLD_MIN_Y || y > WORLD_MAX_Y) return;
+            placements.push_back({x, (short) y, z, block, host});
+        }
+
+        vector<BlockPlacement>& getPlacements() {
+            return placements;
+        }
+    };
+
+    class Feature {
+    public:
+        virtual ~Feature() = default;
+
+        //Заполняет план чанка. Условия на блоки-хосты проверяются при применении плана
+        virtual void plan(Random* random, ChunkManager* world, int chunkX, int chunkZ, DecorationPlan& plan) = 0;
+    };
+
+    //Жилы руды, разрастающиеся случайным блужданием от точки внутри чанка
+    class OreFeature: public Feature {
+    private:
+        BlockHandle ore;
+        BlockHandle host;
+        int veinSize;
+        int veinsPerChunk;
+        int minY;
+        int maxY;
+
+    public:
+        OreFeature(BlockHandle ore, BlockHandle host, int veinSize, int veinsPerChunk, int minY, int maxY) {
+            this->ore = ore;
+            this->host = host;
+            this->veinSize = veinSize;
+            this->veinsPerChunk = veinsPerChunk;
+            this->minY = minY;
+            this->maxY = maxY;
+        }
+
+        void plan(Random* random, ChunkManager* world, int chunkX, int chunkZ, DecorationPlan& plan) override;
+    };
+
+    //Группы одиночных блоков, разбросанных вокруг случайного центра
+    class ScatterFeature: public Feature {
+    private:
+        BlockHandle block;
+        BlockHandle host;
+        int clusters;
+        int clusterSize;
+        int spread;
+        int minY;
+        int maxY;
+
+    public:
+        ScatterFeature(BlockHandle block, BlockHandle host, int clusters, int clusterSize, int spread, int minY, int maxY) {
+            this->block = block;
+            this->host = host;
+            this->clusters = clusters;
+            this->clusterSize = clusterSize;
+            this->spread = spread;
+            this->minY = minY;
+            this->maxY = maxY;
+        }
+
+        void plan(Random* random, ChunkManager* world, int chunkX, int chunkZ, DecorationPlan& plan) override;
+    };
+
+    //Растения на поверхности, ставятся над самым высоким блоком столбца, если он равен ground
+    class SurfacePlantFeature: public Feature {
+    private:
+        BlockHandle plant;
+        BlockHandle ground;
+        int count;
+
+    public:
+        SurfacePlantFeature(BlockHandle plant, BlockHandle ground, int count) {
+            this->plant = plant;
+            this->ground = ground;
+            this->count = count;
+        }
+
+        void plan(Random* random, ChunkManager* world, int chunkX, int chunkZ, DecorationPlan& plan) override;
+    };
+
+    class Decorator {
+    private:
+        vector<Feature*> features;
+
+    public:
+        ~Decorator() {
+            for (Feature* feature: features) delete feature;
+        }
+
+        Decorator* addFeature(Feature* feature) {
+            features.push_back(feature);
+            return this;
+        }
+
+        //Строит план по всем фичам (у каждой свой поток Random) и применяет его одним проходом.
+        //Блоки за пределами чанка уходят в BlockTransaction. На буферном ChunkManager (см. WorldGenerator::generate)
+        //проверка хоста и установка - обращения к массиву столбца, без LevelChunk
+        void decorate(ChunkManager* world, int seed);
+    };
+}
@@ -1,21 +1,45 @@
 #pragma once
 #include "pch.h"
 #include "generator_tools.h"
+#include "decorator.h"
+#include "custom_terrain.h"
+#include <unordered_map>
 
 
-#define WATER_LEVEL 60
+//Сторона группы чанков, для которой generateBatch считает одну сетку шума: 2 - 4x4 чанка
+#define BATCH_GROUP_SHIFT 2
+
 
 class CustomGenerator: public GEN_API::WorldGenerator {
 private:
-    GEN_API::Simplex* simplex;
+    CustomTerrain* terrain;
+    GEN_API::Decorator* decorator;
 
 public:
     CustomGenerator(int seed) : WorldGenerator(seed) {
-        simplex = new GEN_API::Simplex(random, 8, 1/32.0f, 1/64.0f);
+        terrain = new CustomTerrain(random);
+
+        GEN_API::BlockHandle stone = GEN_API::BlockRegistry::intern("minecraft:stone");
+
+        decorator = new GEN_API::Decorator();
+        decorator->addFeature(new GEN_API::OreFeature(GEN_API::BlockRegistry::intern("minecraft:coal_ore"), stone, 12, 16, 5, 120))
+                ->addFeature(new GEN_API::OreFeature(GEN_API::BlockRegistry::intern("minecraft:iron_ore"), stone, 8, 8, 5, 60))
+                ->addFeature(new GEN_API::ScatterFeature(GEN_API::BlockRegistry::intern("minecraft:gravel"), stone, 2, 24, 2, 5, 50))
+                ->addFeature(new GEN_API::SurfacePlantFeature(GEN_API::BlockRegistry::intern("minecraft:tallgrass", 1),
+                                                              GEN_API::BlockRegistry::intern("minecraft:grass"), 24));
+    }
+
+    string getId() const override {
+        return "custom";
+    }
+
+    //Меняйте строку при правке генерации, иначе кэш снимков продолжит отдавать старые чанки
+    size_t getParametersHash() const override {
+        return std::hash<string>()("simplex:8:1/32:1/64;water:" + std::to_string(WATER_LEVEL) + ";decorator:1");
     }
 
     void generateChunk(GEN_API::ChunkManager *world, int chunkX, int chunkZ) override {
-        //TODO: Здесь ваш генератор мира
+        GEN_API::ChunkColumns columns{chunkX, chunkZ};
 
         for (int lx = 0; lx < CHUNK_SIZE; lx++) {
             int gx = (chunkX << COORD_BIT_SIZE) + lx;
@@ -23,11 +47,75 @@ public:
             for (int lz = 0; lz < CHUNK_SIZE; lz++) {
                 int gz = (chunkZ << COORD_BIT_SIZE) + lz;
 
-                world->setBiomeAt(gx, gz, VanillaBiomes::mForest);
+                columns.heights[lx][lz] = (short) terrain->getHeightAt(gx, gz);
+                columns.biomes[lx][lz] = VanillaBiomes::mForest;
+            }
+        }
+
+        generateChunk(world, columns);
+    }
+
+    //Позиции делятся на выровненные квадраты из 1 << BATCH_GROUP_SHIFT чанков по стороне, и сетка шума
+    //считается на каждый квадрат отдельно, поэтому далекие друг от друга чанки не раздувают область
+    bool generateBatch(vector<ChunkPos> const& positions, vector<GEN_API::ChunkColumns>& columns) override {
+        columns.resize(positions.size());
+
+        std::unordered_map<long long, vector<size_t>> groups;
+        for (size_t i = 0; i < positions.size(); i++) {
+            long long key = ((long long) (positions[i].x >> BATCH_GROUP_SHIFT) << 32) | (unsigned int) (positions[i].z >> BATCH_GROUP_SHIFT);
+            groups[key].push_back(i);
+        }
+
+        vector<short> heights;
+        for (auto& group: groups) {
+            vector<size_t> const& indices = group.second;
+
+            int minX = positions[indices[0]].x, maxX = minX;
+            int minZ = positions[indices[0]].z, maxZ = minZ;
+            for (size_t i: indices) {
+                minX = std::min(minX, positions[i].x);
+                maxX = std::max(maxX, positions[i].x);
+                minZ = std::min(minZ, positions[i].z);
+                maxZ = std::max(maxZ, positions[i].z);
+            }
+
+            int width = (maxX - minX + 1) * CHUNK_SIZE;
+            int depth = (maxZ - minZ + 1) * CHUNK_SIZE;
+            heights.resize((size_t) width * depth);
+            terrain->getHeights(heights.data(), minX << COORD_BIT_SIZE, minZ << COORD_BIT_SIZE, width, depth);
+
+            for (size_t i: indices) {
+                columns[i].chunkX = positions[i].x;
+                columns[i].chunkZ = positions[i].z;
+
+                int offsetX = (positions[i].x - minX) * CHUNK_SIZE;
+                int offsetZ = (positions[i].z - minZ) * CHUNK_SIZE;
+
+                for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+                    for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+                        columns[i].heights[lx][lz] = heights[(size_t) (offsetX + lx) * depth + offsetZ + lz];
+                        columns[i].biomes[lx][lz] = VanillaBiomes::mForest;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
 
-                float noise = simplex->noise2D((float) gx, (float) gz);
-                int ty = (int) (noise * 8 + WATER_LEVEL);
-                int yMax = ty < WATER_LEVEL? WATER_LEVEL : ty;
+    void generateChunk(GEN_API::ChunkManager *world, GEN_API::ChunkColumns const& columns) override {
+        //TODO: Здесь ваш генератор мира
+
+        for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+            int gx = (columns.chunkX << COORD_BIT_SIZE) + lx;
+
+            for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+                int gz = (columns.chunkZ << COORD_BIT_SIZE) + lz;
+
+                world->setBiomeAt(gx, gz, columns.biomes[lx][lz]);
+
+                int ty = columns.heights[lx][lz];
+                int yMax = CustomTerrain::isUnderWater(ty)? WATER_LEVEL : ty;
 
                 for (int y = 0; y <= yMax; y++) {
                     Block const* block;
@@ -44,5 +132,7 @@ public:
                 }
             }
         }
+
+        decorator->decorate(world, seed);
     }
 };
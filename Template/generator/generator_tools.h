@@ -1,5 +1,8 @@
 #pragma once
 #include "pch.h"
+#include "block_registry.h"
+#include "noise.h"
+#include <stdexcept>
 
 
 #define C2G_COORD(chunkCoord) (chunkCoord << 4)
@@ -7,46 +10,115 @@
 #define G2L_COORD(coord) (coord & 0xF)
 #define L2G_COORD(chunkCoord, lCoord) (C2G_COORD(chunkCoord) + lCoord)
 
-#define X 123456789
-#define Y 362436069
-#define Z 521288629
-#define W 88675123
-
-#define INT31_VALUE 0x7fffffff
-#define INT32_VALUE 0xffffffff
-
-#define M_SQRT3 1.7320508075689f
-#define F2 (0.5f * (M_SQRT3 - 1.0f))
-#define G2 ((3.0f - M_SQRT3) / 6.0f)
-#define G22 (G2 * 2.0f - 1.0f)
-#define F3 (1.0f / 3.0f)
-#define G3 (1.0f / 6.0f)
-
 #define WORLD_MIN_Y 0
 #define WORLD_MAX_Y 383
+#define WORLD_HEIGHT (WORLD_MAX_Y - WORLD_MIN_Y + 1)
 
 #define CHUNK_SIZE 16
 #define COORD_BIT_SIZE 4
 
 
 namespace GEN_API {
+    class ChunkManager;
+
+    class BlockTransactionElement {
+    private:
+        BlockHandle block;
+        BlockHandle host;
+        char localX;
+        short localY;
+        char localZ;
+        bool placeIsNotFree;
+
+        bool canReplace(Block const& current);
+
+    public:
+        BlockTransactionElement(string encoded);
+
+        //host - блок ставится только на место этого блока, forcePlace тогда не учитывается
+        BlockTransactionElement(int x, short y, int z, BlockHandle block, bool forcePlace, BlockHandle host = BLOCK_HANDLE_INVALID) {
+            localX = G2L_COORD(x);
+            localY = y;
+            localZ = G2L_COORD(z);
+            this->block = block;
+            this->host = host;
+            placeIsNotFree = forcePlace;
+        }
+
+        BlockTransactionElement(int x, short y, int z, string const& blockId, unsigned short tileData, bool forcePlace):
+                BlockTransactionElement(x, y, z, BlockRegistry::intern(blockId, tileData), forcePlace) {
+        }
+
+        void tryPlace(LevelChunk* levelChunk);
+
+        //Через ChunkManager, чтобы блок попал в его карту высот
+        void tryPlace(ChunkManager* chunkManager);
+
+        string encode();
+    };
+
+    void transactionPostProcessingGeneration(LevelChunk* levelChunk, ChunkPos const& chunkPos);
+
+    void createTransactionCache(ChunkPos const& chunkPos, vector<BlockTransactionElement> elements);
+
+    struct ChunkTransactionLink {
+        int x;
+        int z;
+        vector<BlockTransactionElement> elements;
+    };
+
+    //Готовый чанк в компактном виде: блоки столбцов сериями до верхнего блока, биомы и транзакции в соседние чанки
+    struct PrecomputedChunk {
+        int chunkX;
+        int chunkZ;
+        vector<Block const*> palette; //nullptr - пустота, в чанк не ставится
+        vector<std::pair<unsigned short, unsigned short>> runs; //длина серии и индекс в palette, столбец за столбцом
+        short heights[CHUNK_SIZE][CHUNK_SIZE];
+        Biome* biomes[CHUNK_SIZE][CHUNK_SIZE];
+        vector<ChunkTransactionLink> outgoingTransactions;
+    };
+
     class ChunkManager {
     private:
         LevelChunk* levelChunk;
         ChunkPos* chunkPos;
         short** heightMap;
+        vector<ChunkTransactionLink> outgoingTransactions;
 
-    public:
-        ChunkManager(LevelChunk& levelChunk, ChunkPos const& chunkPos) {
-            this->levelChunk = &levelChunk;
-            this->chunkPos = new ChunkPos(chunkPos.x, chunkPos.z);
+        //Буферный режим: блоки по столбцам, [(x * 16 + z) * WORLD_HEIGHT + y]
+        vector<Block const*> buffer;
+        vector<Biome*> biomes;
 
+        void createHeightMap() {
             heightMap = (short**) malloc(16 * sizeof(short*));
             for (char x = 0; x < 16; x++) {
                 heightMap[x] = (short*) calloc(16, sizeof(short));
             }
         }
 
+        static size_t getBufferIndex(int x, int y, int z) {
+            return ((size_t) ((x & 0xF) * CHUNK_SIZE + (z & 0xF))) * WORLD_HEIGHT + (y - WORLD_MIN_Y);
+        }
+
+    public:
+        ChunkManager(LevelChunk& levelChunk, ChunkPos const& chunkPos) {
+            this->levelChunk = &levelChunk;
+            this->chunkPos = new ChunkPos(chunkPos.x, chunkPos.z);
+            createHeightMap();
+        }
+
+        //Буферный режим: в нем идет вся генерация, в том числе на фоновых потоках.
+        //Блоки копятся в памяти и переносятся в настоящий чанк через capture и apply.
+        //Транзакции в соседние чанки не пишутся на диск до apply, getLevelChunk() возвращает nullptr
+        ChunkManager(ChunkPos const& chunkPos) {
+            this->levelChunk = nullptr;
+            this->chunkPos = new ChunkPos(chunkPos.x, chunkPos.z);
+            createHeightMap();
+
+            buffer.assign((size_t) CHUNK_SIZE * CHUNK_SIZE * WORLD_HEIGHT, nullptr);
+            biomes.assign(CHUNK_SIZE * CHUNK_SIZE, nullptr);
+        }
+
         ~ChunkManager() {
             delete chunkPos;
             for (char x = 0; x < 16; x++) free(heightMap[x]);
@@ -54,21 +126,32 @@ namespace GEN_API {
         }
 
         void setBlockAt(int x, int y, int z, string const& stringId) {
-            if(heightMap[x & 0xF][z & 0xF] < y) heightMap[x & 0xF][z & 0xF] = (short) y;
-            levelChunk->setBlockSimple(ChunkBlockPos(G2L_COORD(x), (short) y, G2L_COORD(z)), *Block::create(stringId, 0));
+            setBlockAt(x, y, z, BlockRegistry::intern(stringId, 0));
         }
 
         void setBlockAt(int x, int y, int z, string const& stringId, unsigned short tileData) {
-            if(heightMap[x & 0xF][z & 0xF] < y) heightMap[x & 0xF][z & 0xF] = (short) y;
-            levelChunk->setBlockSimple(ChunkBlockPos(G2L_COORD(x), (short) y, G2L_COORD(z)), *Block::create(stringId, tileData));
+            setBlockAt(x, y, z, BlockRegistry::intern(stringId, tileData));
+        }
+
+        void setBlockAt(int x, int y, int z, BlockHandle handle) {
+            Block const* block = BlockRegistry::get(handle);
+            if (block != nullptr) setBlockAt(x, y, z, block);
         }
 
         void setBlockAt(int x, int y, int z, Block const* block) {
+            if (levelChunk == nullptr) {
+                if (y < WORLD_MIN_Y || y > WORLD_MAX_Y) return;
+                buffer[getBufferIndex(x, y, z)] = block;
+            } else levelChunk->setBlockSimple(ChunkBlockPos(G2L_COORD(x), (short) y, G2L_COORD(z)), *block);
+
             if(heightMap[x & 0xF][z & 0xF] < y) heightMap[x & 0xF][z & 0xF] = (short) y;
-            levelChunk->setBlockSimple(ChunkBlockPos(G2L_COORD(x), (short) y, G2L_COORD(z)), *block);
         }
 
         Block const& getBlockAt(int x, int y, int z) {
+            if (levelChunk == nullptr) {
+                Block const* block = y < WORLD_MIN_Y || y > WORLD_MAX_Y? nullptr : buffer[getBufferIndex(x, y, z)];
+                return block != nullptr? *block : *VanillaBlocks::mAir;
+            }
             return levelChunk->getBlock(ChunkBlockPos(G2L_COORD(x), (short) y, G2L_COORD(z)));
         }
 
@@ -77,14 +160,19 @@ namespace GEN_API {
         }
 
         void setBiomeAt(int x, int z, Biome* biome) {
-            levelChunk->setBiome2d(*biome, ChunkBlockPos(G2L_COORD(x), 0, G2L_COORD(z)));
+            if (levelChunk == nullptr) biomes[(x & 0xF) * CHUNK_SIZE + (z & 0xF)] = biome;
+            else levelChunk->setBiome2d(*biome, ChunkBlockPos(G2L_COORD(x), 0, G2L_COORD(z)));
         }
 
+        //В буферном режиме биом столбца должен быть задан через setBiomeAt
         Biome const& getBiomeAt(int x, int z) {
+            if (levelChunk == nullptr) return *biomes[(x & 0xF) * CHUNK_SIZE + (z & 0xF)];
             return levelChunk->getBiome(ChunkBlockPos(G2L_COORD(x), 0, G2L_COORD(z)));
         }
 
+        //В буферном режиме чанк не связан с миром, обращение к Level с фонового потока небезопасно
         Level& getLevel() {
+            if (levelChunk == nullptr) throw std::logic_error("ChunkManager::getLevel() is not available in buffered mode");
             return levelChunk->getLevel();
         }
 
@@ -95,105 +183,39 @@ namespace GEN_API {
         ChunkPos* getChunkPos() {
             return chunkPos;
         }
-    };
 
-    class Random {
-    private:
-        int seed;
-        long long x;
-        long long y;
-        long long z;
-        long long w;
-
-    public:
-        Random(int seed) {
-            setSeed(seed);
+        //Блоки, отправленные транзакциями в соседние чанки во время генерации
+        void addOutgoingTransaction(ChunkTransactionLink const& link) {
+            outgoingTransactions.push_back(link);
         }
 
-        void setSeed(int seed);
-
-        int getSeed();
-
-        void next();
-
-        int nextSignedInt();
-
-        int nextInt();
-
-        int nextInt(int bound);
-
-        int nextInt(int min, int max);
-
-        float nextFloat();
-
-        float nextSignedFloat();
-
-        bool nextBool();
-    };
-
-    const short SIMPLEX_GRAD3[12][3] = {
-            {1, 1, 0}, {-1, 1, 0}, {1, -1, 0}, {-1, -1, 0},
-            {1, 0, 1}, {-1, 0, 1}, {1, 0, -1}, {-1, 0, -1},
-            {0, 1, 1}, {0, -1, 1}, {0, 1, -1}, {0, -1, -1}
-    };
-
-    class Noise {
-    protected:
-        float persistence;
-        float expansion;
-        int octaves;
-
-    public:
-        Noise(int octaves, float persistence, float expansion) {
-            this->octaves = octaves;
-            this->persistence = persistence;
-            this->expansion = expansion;
+        vector<ChunkTransactionLink> const& getOutgoingTransactions() {
+            return outgoingTransactions;
         }
 
-        virtual float getNoise2D(float x, float z) = 0;
-
-        virtual float getNoise3D(float x, float y, float z) = 0;
+        //Сохраняет содержимое буферного ChunkManager
+        void capture(PrecomputedChunk& chunk);
 
-        virtual float noise2D(float x, float z, bool normalized = false);
-
-        virtual float noise3D(float x, float y, float z, bool normalized = false);
+        //Переносит сохраненный чанк в настоящий и отправляет его транзакции в соседние чанки
+        void apply(PrecomputedChunk const& chunk);
     };
 
-    class Simplex: public Noise {
-    protected:
-        float offsetX;
-        float offsetZ;
-        float offsetY;
-        int perm[512];
-
-    public:
-        Simplex(Random *random, int octaves, float persistence, float expansion) : Noise(octaves, persistence, expansion) {
-            offsetX = random->nextFloat() * 256;
-            offsetY = random->nextFloat() * 256;
-            offsetZ = random->nextFloat() * 256;
-
-            for (int & i : perm) i = 0;
-            for (short i = 0; i < 256; ++i) perm[i] = random->nextInt(256);
-            for (short i = 0; i < 245; ++i) {
-                int pos = random->nextInt(256 - i) + i;
-                int old = perm[i];
-
-                perm[i] = perm[pos];
-                perm[pos] = old;
-                perm[i + 256] = perm[i];
-            }
-
-            random->next();
-        }
-
-        float getNoise2D(float x, float z) override;
-
-        float getNoise3D(float x, float y, float z) override;
+    //Заранее вычисленные высоты поверхности и биомы столбцов чанка
+    struct ChunkColumns {
+        int chunkX;
+        int chunkZ;
+        short heights[CHUNK_SIZE][CHUNK_SIZE];
+        Biome* biomes[CHUNK_SIZE][CHUNK_SIZE];
     };
 
     class WorldGenerator {
+    private:
+        //Random генерируемого сейчас на этом потоке чанка
+        static thread_local Random* chunkRandom;
+
     protected:
         int seed;
+        //Общий Random генератора, только для конструктора. В generateChunk используйте getRandom()
         Random* random;
 
     public:
@@ -210,73 +232,88 @@ namespace GEN_API {
             return seed;
         }
 
-        GEN_API::Random* getRandom() {
-            return random;
+        //Идентификатор генератора и хеш его параметров для кэша снимков чанков.
+        //При изменении логики генерации хеш должен меняться
+        virtual string getId() const {
+            return "default";
         }
 
-        virtual void generateChunk(GEN_API::ChunkManager* world, int chunkX, int chunkZ) {
-
+        virtual size_t getParametersHash() const {
+            return 0;
         }
-    };
 
-    class BlockTransactionElement {
-    private:
-        string blockId;
-        char localX;
-        short localY;
-        char localZ;
-        unsigned short tileData;
-        bool placeIsNotFree;
-
-    public:
-        BlockTransactionElement(string encoded);
-
-        BlockTransactionElement(int x, short y, int z, string const& blockId, unsigned short tileData, bool forcePlace) {
-            localX = G2L_COORD(x);
-            localY = y;
-            localZ = G2L_COORD(z);
-            this->blockId = "" + blockId;
-            this->tileData = tileData;
-            placeIsNotFree = forcePlace;
+        //Внутри generateChunk - свой Random чанка, засеянный по его координатам, вне генерации - общий
+        GEN_API::Random* getRandom() {
+            return chunkRandom != nullptr? chunkRandom : random;
         }
 
-        void tryPlace(LevelChunk* levelChunk);
+        //Сид Random чанка, одинаковый для хука и предварительной генерации
+        int getChunkSeed(int chunkX, int chunkZ) const {
+            return (int) (0xdeadbeef ^ (chunkX << 8) ^ chunkZ ^ seed);
+        }
 
-        string encode();
-    };
+        //Генерирует чанк через generateChunk с Random чанка. columns == nullptr - без пакетных столбцов.
+        //generateChunk всегда получает буферный ChunkManager: проверки блоков (хосты декораций, транзакции)
+        //читают массив, а в настоящий чанк блоки переносятся одним проходом по столбцам
+        void generate(GEN_API::ChunkManager* world, ChunkColumns const* columns);
+
+        //Генерация чанка. world буферный (см. ChunkManager), вызов может идти с фонового потока
+        //параллельно с другими чанками. Поэтому generateChunk:
+        //- берет случайные числа только из getRandom(), результат должен зависеть только от сида и координат;
+        //- не обращается к миру: getLevelChunk() возвращает nullptr, getLevel() бросает std::logic_error;
+        //- видит через getBlockAt только блоки своего чанка;
+        //- не меняет состояние генератора, кроме потокобезопасного.
+        //Транзакции в соседние чанки записываются при переносе чанка в мир
+        virtual void generateChunk(GEN_API::ChunkManager* world, int chunkX, int chunkZ) {
 
-    void transactionPostProcessingGeneration(LevelChunk* levelChunk, ChunkPos const& chunkPos);
+        }
 
-    void createTransactionCache(ChunkPos const& chunkPos, vector<BlockTransactionElement> elements);
+        //Вычисляет столбцы сразу для группы соседних чанков, чтобы шум считался одним проходом.
+        //false - генератор не поддерживает пакетную генерацию. Вызывается с фоновых потоков и не использует getRandom()
+        virtual bool generateBatch(vector<ChunkPos> const& positions, vector<ChunkColumns>& columns) {
+            return false;
+        }
 
-    struct ChunkTransactionLink {
-        int x;
-        int z;
-        vector<BlockTransactionElement> elements;
+        //Генерация чанка по столбцам, полученным из generateBatch. Ограничения те же, что у generateChunk выше
+        virtual void generateChunk(GEN_API::ChunkManager* world, ChunkColumns const& columns) {
+            generateChunk(world, columns.chunkX, columns.chunkZ);
+        }
     };
 
     class BlockTransaction {
     private:
         vector<ChunkTransactionLink> chunks;
+
+        void addElement(int chunkX, int chunkZ, BlockTransactionElement const& element);
+
     public:
         BlockTransaction() {
             chunks = vector<ChunkTransactionLink>();
         }
 
         void addBlock(int x, short y, int z, Block const* block, bool force = true) {
-            addBlock(x, y, z, block->getTypeName(), 0, force);
+            addBlock(x, y, z, BlockRegistry::intern(block), force);
         }
 
-        void addBlock(int x, short y, int z, string blockId, bool force = true) {
-            addBlock(x, y, z, std::move(blockId), 0, force);
+        void addBlock(int x, short y, int z, string const& blockId, bool force = true) {
+            addBlock(x, y, z, BlockRegistry::intern(blockId, 0), force);
         }
 
-        void addBlock(int x, short y, int z, string blockId, unsigned short tileData, bool force = true);
+        void addBlock(int x, short y, int z, string const& blockId, unsigned short tileData, bool force = true) {
+            addBlock(x, y, z, BlockRegistry::intern(blockId, tileData), force);
+        }
+
+        void addBlock(int x, short y, int z, BlockHandle block, bool force = true);
 
-        void apply(ChunkManager* chunkManager) {
-            apply(chunkManager->getLevelChunk(), chunkManager->getChunkPos());
+        //Блок заменит только host, например руда только камень
+        void addBlockReplacing(int x, short y, int z, Block const* block, Block const* host) {
+            addBlockReplacing(x, y, z, BlockRegistry::intern(block), BlockRegistry::intern(host));
         }
 
+        void addBlockReplacing(int x, short y, int z, BlockHandle block, BlockHandle host);
+
+        void apply(ChunkManager* chunkManager);
+
         void apply(LevelChunk* levelChunk, ChunkPos* chunkPos);
     };
 }
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include "noise.h"
+
+#define m_t4(val) (val * val * val * val)
+
+
+//Константы только для этого файла, чтобы короткие имена не попадали в код, подключающий noise.h
+namespace {
+    constexpr int X = 123456789;
+    constexpr int Y = 362436069;
+    constexpr int Z = 521288629;
+    constexpr int W = 88675123;
+
+    constexpr int INT31_VALUE = 0x7fffffff;
+    constexpr unsigned int INT32_VALUE = 0xffffffff;
+
+    constexpr float M_SQRT3 = 1.7320508075689f;
+    constexpr float F2 = 0.5f * (M_SQRT3 - 1.0f);
+    constexpr float G2 = (3.0f - M_SQRT3) / 6.0f;
+    constexpr float G22 = G2 * 2.0f - 1.0f;
+    constexpr float F3 = 1.0f / 3.0f;
+    constexpr float G3 = 1.0f / 6.0f;
+}
+
+
+void GEN_API::Random::setSeed(int newSeed) {
+    seed = newSeed;
+    x = X ^ seed;
+    y = Y ^ (seed << 17) | ((seed >> 15) & INT31_VALUE) & INT32_VALUE;
+    z = Z ^ (seed << 31) | ((seed >> 1) & INT31_VALUE) & INT32_VALUE;
+    w = W ^ (seed << 18) | ((seed >> 14) & INT31_VALUE) & INT32_VALUE;
+}
+
+int GEN_API::Random::getSeed() {
+    return seed;
+}
+
+void GEN_API::Random::next() {
+    long long t = (x ^ (x << 11)) & INT32_VALUE;
+
+    x = y;
+    y = z;
+    z = w;
+    w = (w ^ ((w >> 19) & INT31_VALUE) ^ (t ^ ((t >> 8) & INT31_VALUE))) & INT32_VALUE;
+}
+
+int GEN_API::Random::nextSignedInt() {
+    next();
+    return (int) w;
+}
+
+int GEN_API::Random::nextInt() {
+    return nextSignedInt() & INT31_VALUE;
+}
+
+int GEN_API::Random::nextInt(int bound) {
+    return nextInt() % bound;
+}
+
+int GEN_API::Random::nextInt(int min, int max) {
+    return min + (nextInt() % (max + 1 - min));
+}
+
+float GEN_API::Random::nextFloat() {
+    return nextInt() / (float) INT31_VALUE;
+}
+
+float GEN_API::Random::nextSignedFloat() {
+    return nextSignedInt() / (float) INT31_VALUE;
+}
+
+bool GEN_API::Random::nextBool() {
+    return (nextInt() & 0x01) == 0;
+}
+
+float GEN_API::Noise::noise2D(float x, float z, bool normalized) {
+    float result = 0;
+    float amp = 1.0f;
+    float freq = 1.0f;
+    float max = 0.0f;
+
+    x *= expansion;
+    z *= expansion;
+
+    for (int i = 0; i < octaves; ++i) {
+        result += getNoise2D(x * freq, z * freq) * amp;
+        max += amp;
+        freq *= 2.0f;
+        amp *= persistence;
+    }
+
+    return normalized? (result / max) : result;
+}
+
+float GEN_API::Noise::noise3D(float x, float y, float z, bool normalized) {
+    float result = 0;
+    float amp = 1.0f;
+    float freq = 1.0f;
+    float max = 0.0f;
+
+    x *= expansion;
+    z *= expansion;
+
+    for (int i = 0; i < octaves; ++i) {
+        result += getNoise3D(x * freq, y * freq, z * freq) * amp;
+        max += amp;
+        freq *= 2.0f;
+        amp *= persistence;
+    }
+
+    return normalized? (result / max) : result;
+}
+
+void GEN_API::Noise::addNoise2D(GridPoint* points, int count, float freq, float amp) {
+    for (int i = 0; i < count; ++i) points[i].value += getNoise2D(points[i].x * freq, points[i].z * freq) * amp;
+}
+
+void GEN_API::Noise::noise2DGrid(float* out, int startX, int startZ, int width, int depth, bool normalized, int step) {
+    float amp = 1.0f;
+    float freq = 1.0f;
+    float max = 0.0f;
+
+    for (int i = 0; i < width * depth; ++i) out[i] = 0;
+
+    for (int i = 0; i < octaves; ++i) {
+        for (int dx = 0; dx < width; ++dx) {
+            float x = (float) (startX + dx * step) * expansion * freq;
+            float* row = out + dx * depth;
+
+            for (int dz = 0; dz < depth; ++dz) {
+                row[dz] += getNoise2D(x, (float) (startZ + dz * step) * expansion * freq) * amp;
+            }
+        }
+
+        max += amp;
+        freq *= 2.0f;
+        amp *= persistence;
+    }
+
+    if (normalized) {
+        for (int i = 0; i < width * depth; ++i) out[i] /= max;
+    }
+}
+
+bool GEN_API::Noise::noise2DThreshold(float x, float z, float threshold, bool normalized) {
+    return progressiveNoise2D(x, z, normalized, [threshold](float low, float high) {
+        return low > threshold || high <= threshold;
+    }) > threshold;
+}
+
+bool GEN_API::Noise::noise3DThreshold(float x, float y, float z, float threshold, bool normalized) {
+    return progressiveNoise3D(x, y, z, normalized, [threshold](float low, float high) {
+        return low > threshold || high <= threshold;
+    }) > threshold;
+}
+
+float GEN_API::Simplex::getNoise2D(float x, float y) {
+    x += offsetX;
+    y += offsetY;
+
+    float s = (x + y) * F2;
+    int i = (int) (x + s);
+    int j = (int) (y + s);
+    float t = (i + j) * G2;
+
+    float x0 = x - (i - t);
+    float y0 = y - (j - t);
+
+    int i1, j1;
+    if (x0 > y0) {
+        i1 = 1;
+        j1 = 0;
+    } else {
+        i1 = 0;
+        j1 = 1;
+    }
+
+    float x1 = x0 - i1 + G2;
+    float y1 = y0 - j1 + G2;
+    float x2 = x0 + G22;
+    float y2 = y0 + G22;
+
+    int ii = i & 255;
+    int jj = j & 255;
+
+    float n = 0;
+    float ti;
+
+    ti = 0.5f - x0 * x0 - y0 * y0;
+    if (ti > 0) {
+        const short index = permGrad[ii + perm[jj]];
+        n += m_t4(ti) * (GEN_API::SIMPLEX_GRAD3[index][0] * x0 + GEN_API::SIMPLEX_GRAD3[index][1] * y0);
+    }
+
+    ti = 0.5f - x1 * x1 - y1 * y1;
+    if (ti > 0) {
+        const short index = permGrad[ii + i1 + perm[jj + j1]];
+        n += m_t4(ti) * (GEN_API::SIMPLEX_GRAD3[index][0] * x1 + GEN_API::SIMPLEX_GRAD3[index][1] * y1);
+    }
+
+    ti = 0.5f - x2 * x2 - y2 * y2;
+    if (ti > 0) {
+        const short index = permGrad[ii + 1 + perm[jj + 1]];
+        n += m_t4(ti) * (GEN_API::SIMPLEX_GRAD3[index][0] * x2 + GEN_API::SIMPLEX_GRAD3[index][1] * y2);
+    }
+
+    return 70.0f * n;
+}
+
+float GEN_API::Simplex::getNoise3D(float x, float y, float z) {
+    x += offsetX;
+    y += offsetY;
+    z += offsetZ;
+
+    float s = (x + y + z) * F3;
+    int i = (int) (x + s);
+    int j = (int) (y + s);
+    int k = (int) (z + s);
+    float t = (i + j + k) * G3;
+
+    float x0 = x - (i - t);
+    float y0 = y - (j - t);
+    float z0 = z - (k - t);
+
+    char i1, j1, k1, i2, j2, k2;
+    if (x0 >= y0) {
+        if (y0 >= z0) {
+            i1 = 1;
+            j1 = 0;
+            k1 = 0;
+            i2 = 1;
+            j2 = 1;
+            k2 = 0;
+        } else if (x0 >= z0) {
+            i1 = 1;
+            j1 = 0;
+            k1 = 0;
+            i2 = 1;
+            j2 = 0;
+            k2 = 1;
+        } else {
+            i1 = 0;
+            j1 = 0;
+            k1 = 1;
+            i2 = 1;
+            j2 = 0;
+            k2 = 1;
+        }
+    } else {
+        if (y0 < z0) {
+            i1 = 0;
+            j1 = 0;
+            k1 = 1;
+            i2 = 0;
+            j2 = 1;
+            k2 = 1;
+        } else if (x0 < z0) {
+            i1 = 0;
+            j1 = 1;
+            k1 = 0;
+            i2 = 0;
+            j2 = 1;
+            k2 = 1;
+        } else {
+            i1 = 0;
+            j1 = 1;
+            k1 = 0;
+            i2 = 1;
+            j2 = 1;
+            k2 = 0;
+        }
+    }
+
+    float x1 = x0 - i1 + G3;
+    float y1 = y0 - j1 + G3;
+    float z1 = z0 - k1 + G3;
+    float x2 = x0 - i2 + 2.0f * G3;
+    float y2 = y0 - j2 + 2.0f * G3;
+    float z2 = z0 - k2 + 2.0f * G3;
+    float x3 = x0 - 1.0f + 3.0f * G3;
+    float y3 = y0 - 1.0f + 3.0f * G3;
+    float z3 = z0 - 1.0f + 3.0f * G3;
+
+    short ii = i & 255;
+    short jj = j & 255;
+    short kk = k & 255;
+
+    float n = 0;
+    float ti;
+
+    ti = 0.6f - x0 * x0 - y0 * y0 - z0 * z0;
+    if(ti > 0){
+        auto gi0 = SIMPLEX_GRAD3[permGrad[ii + perm[jj + perm[kk]]]];
+        n += ti * ti * ti * ti * (gi0[0] * x0 + gi0[1] * y0 + gi0[2] * z0);
+    }
+
+    ti = 0.6f - x1 * x1 - y1 * y1 - z1 * z1;
+    if(ti > 0){
+        auto gi1 = SIMPLEX_GRAD3[permGrad[ii + i1 + perm[jj + j1 + perm[kk + k1]]]];
+        n += ti * ti * ti * ti * (gi1[0] * x1 + gi1[1] * y1 + gi1[2] * z1);
+    }
+
+    ti = 0.6f - x2 * x2 - y2 * y2 - z2 * z2;
+    if(ti > 0){
+        auto gi2 = SIMPLEX_GRAD3[permGrad[ii + i2 + perm[jj + j2 + perm[kk + k2]]]];
+        n += ti * ti * ti * ti * (gi2[0] * x2 + gi2[1] * y2 + gi2[2] * z2);
+    }
+
+    ti = 0.6f - x3 * x3 - y3 * y3 - z3 * z3;
+    if(ti > 0){
+        auto gi3 = SIMPLEX_GRAD3[permGrad[ii + 1 + perm[jj + 1 + perm[kk + 1]]]];
+        n += ti * ti * ti * ti * (gi3[0] * x3 + gi3[1] * y3 + gi3[2] * z3);
+    }
+
+    return 32.0f * n;
+}
+
+void GEN_API::Simplex::addNoise2D(GridPoint* points, int count, float freq, float amp) {
+    //Без виртуального вызова на каждую точку
+    for (int i = 0; i < count; ++i) points[i].value += Simplex::getNoise2D(points[i].x * freq, points[i].z * freq) * amp;
+}
+
+float GEN_API::Simplex::getOctaveBound() {
+    //Измеренный максимум |шума| - 0.998 в 2D и 0.978 в 3D, граница взята с запасом
+    return 1.05f;
+}
@@ -0,0 +1,249 @@
+#pragma once
+//Шум и Random не зависят от SDK, поэтому используются и плагином, и утилитой Preview
+#include <vector>
+
+
+namespace GEN_API {
+    class Random {
+    private:
+        int seed;
+        long long x;
+        long long y;
+        long long z;
+        long long w;
+
+    public:
+        Random(int seed) {
+            setSeed(seed);
+        }
+
+        void setSeed(int seed);
+
+        int getSeed();
+
+        void next();
+
+        int nextSignedInt();
+
+        int nextInt();
+
+        int nextInt(int bound);
+
+        int nextInt(int min, int max);
+
+        float nextFloat();
+
+        float nextSignedFloat();
+
+        bool nextBool();
+    };
+
+    const short SIMPLEX_GRAD3[12][3] = {
+            {1, 1, 0}, {-1, 1, 0}, {1, -1, 0}, {-1, -1, 0},
+            {1, 0, 1}, {-1, 0, 1}, {1, 0, -1}, {-1, 0, -1},
+            {0, 1, 1}, {0, -1, 1}, {0, 1, -1}, {0, -1, -1}
+    };
+
+    class Noise {
+    protected:
+        struct GridPoint {
+            float x;
+            float z;
+            float value;
+            int index;
+        };
+
+        float persistence;
+        float expansion;
+        int octaves;
+        float amplitudeSum;
+
+        //value += getNoise2D(x * freq, z * freq) * amp для каждой точки
+        virtual void addNoise2D(GridPoint* points, int count, float freq, float amp);
+
+        //Суммирует октавы, пока isDecided(low, high) не подтвердит, что результат уже не выйдет из [low, high]
+        template<typename Decided>
+        float progressiveNoise2D(float x, float z, bool normalized, Decided const& isDecided) {
+            float result = 0;
+            float amp = 1.0f;
+            float freq = 1.0f;
+            float bound = getOctaveBound();
+            float remaining = amplitudeSum * bound;
+            float scale = normalized? (1.0f / amplitudeSum) : 1.0f;
+
+            x *= expansion;
+            z *= expansion;
+
+            for (int i = 0; i < octaves; ++i) {
+                result += getNoise2D(x * freq, z * freq) * amp;
+                remaining -= amp * bound;
+                freq *= 2.0f;
+                amp *= persistence;
+
+                if (bound > 0 && i + 1 < octaves && isDecided((result - remaining) * scale, (result + remaining) * scale)) break;
+            }
+
+            return result * scale;
+        }
+
+        template<typename Decided>
+        float progressiveNoise3D(float x, float y, float z, bool normalized, Decided const& isDecided) {
+            float result = 0;
+            float amp = 1.0f;
+            float freq = 1.0f;
+            float bound = getOctaveBound();
+            float remaining = amplitudeSum * bound;
+            float scale = normalized? (1.0f / amplitudeSum) : 1.0f;
+
+            x *= expansion;
+            z *= expansion;
+
+            for (int i = 0; i < octaves; ++i) {
+                result += getNoise3D(x * freq, y * freq, z * freq) * amp;
+                remaining -= amp * bound;
+                freq *= 2.0f;
+                amp *= persistence;
+
+                if (bound > 0 && i + 1 < octaves && isDecided((result - remaining) * scale, (result + remaining) * scale)) break;
+            }
+
+            return result * scale;
+        }
+
+    public:
+        Noise(int octaves, float persistence, float expansion) {
+            this->octaves = octaves;
+            this->persistence = persistence;
+            this->expansion = expansion;
+
+            amplitudeSum = 0.0f;
+            float amp = 1.0f;
+            for (int i = 0; i < octaves; ++i) {
+                amplitudeSum += amp;
+                amp *= persistence;
+            }
+        }
+
+        virtual ~Noise() = default;
+
+        virtual float getNoise2D(float x, float z) = 0;
+
+        virtual float getNoise3D(float x, float y, float z) = 0;
+
+        virtual float noise2D(float x, float z, bool normalized = false);
+
+        virtual float noise3D(float x, float y, float z, bool normalized = false);
+
+        //Верхняя граница |getNoise2D| и |getNoise3D| одной октавы. 0 - неизвестна, тогда октавы не отбрасываются
+        virtual float getOctaveBound() {
+            return 0;
+        }
+
+        //Октавы суммируются до тех пор, пока оставшиеся могут изменить результат quantize.
+        //quantize должна быть неубывающей, например (int) (noise * 8 + WATER_LEVEL)
+        template<typename Quantize>
+        int noise2DQuantized(float x, float z, Quantize const& quantize, bool normalized = false) {
+            return quantize(progressiveNoise2D(x, z, normalized, [&quantize](float low, float high) {
+                return quantize(low) == quantize(high);
+            }));
+        }
+
+        template<typename Quantize>
+        int noise3DQuantized(float x, float y, float z, Quantize const& quantize, bool normalized = false) {
+            return quantize(progressiveNoise3D(x, y, z, normalized, [&quantize](float low, float high) {
+                return quantize(low) == quantize(high);
+            }));
+        }
+
+        //Эквивалентно noise2D(x, z, normalized) > threshold, но без лишних октав
+        bool noise2DThreshold(float x, float z, float threshold, bool normalized = false);
+
+        bool noise3DThreshold(float x, float y, float z, float threshold, bool normalized = false);
+
+        //Значения noise2D для сетки width x depth точек с шагом step блоков, out[dx * depth + dz].
+        //Октавы идут во внешнем цикле, результат совпадает с поточечным noise2D
+        void noise2DGrid(float* out, int startX, int startZ, int width, int depth, bool normalized = false, int step = 1);
+
+        //noise2DQuantized для той же сетки. После каждой октавы из обхода убираются точки,
+        //результат которых уже определен, поэтому сетка не дороже поточечного вызова
+        template<typename T, typename Quantize>
+        void noise2DGridQuantized(T* out, int startX, int startZ, int width, int depth, Quantize const& quantize, bool normalized = false, int step = 1) {
+            int count = width * depth;
+            std::vector<GridPoint> active(count);
+            for (int dx = 0; dx < width; ++dx) {
+                float x = (float) (startX + dx * step) * expansion;
+                for (int dz = 0; dz < depth; ++dz) {
+                    active[dx * depth + dz] = {x, (float) (startZ + dz * step) * expansion, 0.0f, dx * depth + dz};
+                }
+            }
+
+            float amp = 1.0f;
+            float freq = 1.0f;
+            float bound = getOctaveBound();
+            float remaining = amplitudeSum * bound;
+            float scale = normalized? (1.0f / amplitudeSum) : 1.0f;
+
+            for (int octave = 0; octave < octaves && count > 0; ++octave) {
+                bool last = octave + 1 == octaves || bound <= 0;
+                int left = 0;
+
+                float rest = remaining - amp * bound;
+
+                addNoise2D(active.data(), count, freq, amp);
+
+                for (int n = 0; n < count; ++n) {
+                    GridPoint const& point = active[n];
+                    if (!last && quantize((point.value - rest) * scale) == quantize((point.value + rest) * scale)) {
+                        out[point.index] = (T) quantize(point.value * scale);
+                    } else active[left++] = point;
+                }
+
+                count = left;
+                remaining = rest;
+                freq *= 2.0f;
+                amp *= persistence;
+            }
+
+            for (int n = 0; n < count; ++n) out[active[n].index] = (T) quantize(active[n].value * scale);
+        }
+    };
+
+    class Simplex: public Noise {
+    protected:
+        float offsetX;
+        float offsetZ;
+        float offsetY;
+        int perm[512];
+        short permGrad[512]; //perm % 12 - индекс градиента без деления в каждой вершине
+
+    public:
+        Simplex(Random *random, int octaves, float persistence, float expansion) : Noise(octaves, persistence, expansion) {
+            offsetX = random->nextFloat() * 256;
+            offsetY = random->nextFloat() * 256;
+            offsetZ = random->nextFloat() * 256;
+
+            for (int & i : perm) i = 0;
+            for (short i = 0; i < 256; ++i) perm[i] = random->nextInt(256);
+            for (short i = 0; i < 245; ++i) {
+                int pos = random->nextInt(256 - i) + i;
+                int old = perm[i];
+
+                perm[i] = perm[pos];
+                perm[pos] = old;
+                perm[i + 256] = perm[i];
+            }
+            for (int i = 0; i < 512; ++i) permGrad[i] = (short) (perm[i] % 12);
+
+            random->next();
+        }
+
+        float getNoise2D(float x, float z) override;
+
+        float getNoise3D(float x, float y, float z) override;
+
+        float getOctaveBound() override;
+
+    protected:
+        void addNoise2D(GridPoint* points, int count, float freq, float amp) override;
+    };
+}
@@ -0,0 +1,151 @@
+#include "prefetcher.h"
+#include <MC/ChunkSource.hpp>
+#include <Windows.h>
+
+#define CHUNK_KEY(x, z) (((long long) (x) << 32) | (unsigned int) (z))
+
+
+GEN_API::ChunkPrefetcher::ChunkPrefetcher(WorldGenerator* generator, int threads, size_t maxChunks, int lookaheadTicks, int radius) {
+    this->generator = generator;
+    this->maxChunks = maxChunks < 1? 1 : maxChunks;
+    this->lookaheadTicks = lookaheadTicks;
+    this->radius = radius;
+
+    running = true;
+    hits = 0;
+    misses = 0;
+    evicted = 0;
+    failed = 0;
+
+    for (int i = 0; i < threads; i++) workers.emplace_back(&ChunkPrefetcher::work, this);
+}
+
+GEN_API::ChunkPrefetcher::~ChunkPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    condition.notify_all();
+
+    for (auto& worker: workers) worker.join();
+}
+
+void GEN_API::ChunkPrefetcher::schedule(ChunkSource& chunkSource, int chunkX, int chunkZ) {
+    long long key = CHUNK_KEY(chunkX, chunkZ);
+    if (!scheduled.insert(key).second) return;
+
+    //Чанк уже есть в мире или на диске, он остается в scheduled и больше не проверяется
+    if (chunkSource.isChunkKnown(ChunkPos(chunkX, chunkZ))) return;
+
+    queue.push_back(key);
+    while (queue.size() > maxChunks) {
+        scheduled.erase(queue.front());
+        queue.pop_front();
+    }
+}
+
+void GEN_API::ChunkPrefetcher::tick() {
+    BlockSource* region = Level::getBlockSource(0);
+    if (region == nullptr) return;
+
+    ChunkSource& chunkSource = region->getChunkSource();
+    bool added = false;
+
+    for (Player* player: Level::getAllPlayers()) {
+        if (player->getDimensionId() != 0) continue;
+
+        Vec3 position = player->getPosition();
+        Vec3 delta = player->getPosDelta();
+        if (delta.x * delta.x + delta.z * delta.z < PREFETCH_MIN_SPEED * PREFETCH_MIN_SPEED) continue;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        //Список уже сгенерированных чанков не хранится, поэтому он периодически сбрасывается до текущей работы
+        if (scheduled.size() > maxChunks * 8) {
+            scheduled.clear();
+            for (long long key: queue) scheduled.insert(key);
+            for (auto& entry: ready) scheduled.insert(entry.first);
+        }
+
+        //Воркеры берут задачи с конца очереди, поэтому ближайшие точки пути добавляются последними
+        for (int t = lookaheadTicks; t >= PREFETCH_STEP_TICKS; t -= PREFETCH_STEP_TICKS) {
+            int chunkX = G2C_COORD((int) std::floor(position.x + delta.x * t));
+            int chunkZ = G2C_COORD((int) std::floor(position.z + delta.z * t));
+
+            for (int dx = -radius; dx <= radius; dx++) {
+                for (int dz = -radius; dz <= radius; dz++) schedule(chunkSource, chunkX + dx, chunkZ + dz);
+            }
+        }
+        added = true;
+    }
+
+    if (added) condition.notify_all();
+}
+
+bool GEN_API::ChunkPrefetcher::take(ChunkManager* world) {
+    long long key = CHUNK_KEY(world->getChunkPos()->x, world->getChunkPos()->z);
+    PrecomputedChunk chunk;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto found = ready.find(key);
+        if (found == ready.end()) {
+            scheduled.insert(key);
+            misses++;
+            return false;
+        }
+
+        chunk = std::move(found->second);
+        ready.erase(found);
+        hits++;
+    }
+
+    world->apply(chunk);
+    return true;
+}
+
+void GEN_API::ChunkPrefetcher::work() {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+
+    vector<ChunkPos> positions;
+    vector<ChunkColumns> columns;
+
+    while (true) {
+        long long key;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return !running || !queue.empty(); });
+            if (!running) return;
+
+            key = queue.back();
+            queue.pop_back();
+        }
+
+        ChunkPos chunkPos((int) (key >> 32), (int) key);
+        ChunkManager world(chunkPos);
+
+        positions.clear();
+        positions.push_back(chunkPos);
+
+        //Генератор, которому нужен мир (getLevel), не может работать в буферном режиме, такой чанк сгенерирует хук
+        try {
+            bool batched = generator->generateBatch(positions, columns) && columns.size() == 1;
+            generator->generate(&world, batched? &columns[0] : nullptr);
+        } catch (std::logic_error const&) {
+            failed++;
+            continue;
+        }
+
+        PrecomputedChunk chunk;
+        world.capture(chunk);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ready[key] = std::move(chunk);
+        readyOrder.push_back(key);
+
+        while (ready.size() > maxChunks || readyOrder.size() > maxChunks * 2) {
+            if (ready.erase(readyOrder.front()) > 0) evicted++;
+            readyOrder.pop_front();
+        }
+    }
+}
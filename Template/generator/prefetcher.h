@@ -0,0 +1,78 @@
+#pragma once
+#include "pch.h"
+#include "generator_tools.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+
+
+//Минимальная горизонтальная скорость игрока (блоков за тик), с которой начинается предсказание
+#define PREFETCH_MIN_SPEED 0.4f
+//Шаг по времени между предсказанными точками пути, в тиках
+#define PREFETCH_STEP_TICKS 10
+
+
+namespace GEN_API {
+    //Предсказывает по скорости игроков чанки, до которых они скоро долетят, и заранее полностью
+    //генерирует их (блоки и декорации) в буферный ChunkManager на фоновых потоках с низким приоритетом.
+    //Уже существующие чанки пропускаются. Хук buildSurfaces забирает готовый чанк через take
+    //и только копирует его. Чанк генерируется через WorldGenerator::generate с тем же Random чанка,
+    //что и в хуке, поэтому совпадает с обычным. Требования к generateChunk описаны в WorldGenerator
+    class ChunkPrefetcher {
+    private:
+        WorldGenerator* generator;
+        size_t maxChunks;
+        int lookaheadTicks;
+        int radius;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<long long> queue;
+        std::unordered_set<long long> scheduled;
+        std::unordered_map<long long, PrecomputedChunk> ready;
+        std::deque<long long> readyOrder;
+        vector<std::thread> workers;
+        bool running;
+
+        std::atomic<unsigned long long> hits;
+        std::atomic<unsigned long long> misses;
+        std::atomic<unsigned long long> evicted;
+        std::atomic<unsigned long long> failed;
+
+        void schedule(ChunkSource& chunkSource, int chunkX, int chunkZ);
+
+        void work();
+
+    public:
+        ChunkPrefetcher(WorldGenerator* generator, int threads, size_t maxChunks, int lookaheadTicks, int radius);
+
+        ~ChunkPrefetcher();
+
+        //Вызывается каждый тик сервера
+        void tick();
+
+        //true - чанк уже был сгенерирован заранее и перенесен в world
+        bool take(ChunkManager* world);
+
+        unsigned long long getHits() const {
+            return hits;
+        }
+
+        unsigned long long getMisses() const {
+            return misses;
+        }
+
+        unsigned long long getEvicted() const {
+            return evicted;
+        }
+
+        //Чанки, которые генератор не смог построить в буферном режиме
+        unsigned long long getFailed() const {
+            return failed;
+        }
+    };
+}
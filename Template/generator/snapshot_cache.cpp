@@ -0,0 +1,274 @@
+#include "snapshot_cache.h"
+#include <Windows.h>
+#include <cstring>
+#include <unordered_map>
+#include <sstream>
+#include <iomanip>
+
+using std::to_string;
+
+
+template<typename T>
+static void writeValue(string& out, T value) {
+    out.append((char const*) &value, sizeof(T));
+}
+
+static void writeString(string& out, string const& value) {
+    writeValue(out, (unsigned short) value.length());
+    out.append(value);
+}
+
+class SnapshotReader {
+private:
+    char const* data;
+    size_t size;
+    size_t offset;
+    bool failed;
+
+public:
+    SnapshotReader(char const* data, size_t size) {
+        this->data = data;
+        this->size = size;
+        offset = 0;
+        failed = false;
+    }
+
+    template<typename T>
+    T read() {
+        T value{};
+        if (failed || offset + sizeof(T) > size) {
+            failed = true;
+            return value;
+        }
+        memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    string readString() {
+        auto length = read<unsigned short>();
+        if (failed || offset + length > size) {
+            failed = true;
+            return "";
+        }
+        string value(data + offset, length);
+        offset += length;
+        return value;
+    }
+
+    bool isFailed() const {
+        return failed;
+    }
+};
+
+GEN_API::ChunkSnapshotCache::ChunkSnapshotCache(string const& rootPath, WorldGenerator* generator) {
+    std::stringstream key;
+    key << generator->getId() << "-" << std::hex << generator->getParametersHash() << std::dec << "-" << generator->getSeed();
+
+    directory = std::filesystem::path(rootPath) / key.str();
+    std::filesystem::create_directories(directory);
+}
+
+std::filesystem::path GEN_API::ChunkSnapshotCache::getPath(ChunkPos const* chunkPos) {
+    return directory / (to_string(chunkPos->x) + "." + to_string(chunkPos->z));
+}
+
+bool GEN_API::ChunkSnapshotCache::replay(ChunkManager* world) {
+    std::filesystem::path path = getPath(world->getChunkPos());
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    char const* data = mapping != nullptr? (char const*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (data == nullptr) {
+        if (mapping != nullptr) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    SnapshotReader reader(data, (size_t) fileSize.QuadPart);
+    bool valid = reader.read<unsigned int>() == SNAPSHOT_MAGIC && reader.read<unsigned short>() == SNAPSHOT_VERSION;
+
+    vector<Block const*> palette;
+    Biome* biomes[CHUNK_SIZE * CHUNK_SIZE];
+    short heights[CHUNK_SIZE * CHUNK_SIZE];
+
+    if (valid) {
+        auto paletteSize = reader.read<unsigned short>();
+        for (int i = 0; i < paletteSize && !reader.isFailed(); i++) {
+            string blockId = reader.readString();
+            auto tileData = reader.read<unsigned short>();
+            palette.push_back(BlockRegistry::get(BlockRegistry::intern(blockId, tileData)));
+        }
+
+        for (auto& biome: biomes) biome = Biome::fromId(reader.read<int>());
+        for (auto& height: heights) height = reader.read<short>();
+
+        valid = !reader.isFailed();
+        for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE && valid; i++) {
+            valid = heights[i] >= WORLD_MIN_Y && heights[i] <= WORLD_MAX_Y;
+        }
+        for (Block const* block: palette) valid = valid && block != nullptr;
+    }
+
+    //Сначала разбираем снимок полностью, чтобы поврежденный файл не оставил чанк наполовину заполненным
+    vector<std::pair<unsigned short, unsigned short>> runs;
+    for (int column = 0; column < CHUNK_SIZE * CHUNK_SIZE && valid; column++) {
+        int left = heights[column] - WORLD_MIN_Y + 1;
+        while (left > 0 && valid) {
+            auto length = reader.read<unsigned short>();
+            auto index = reader.read<unsigned short>();
+            valid = !reader.isFailed() && length > 0 && length <= left && index < palette.size();
+            runs.emplace_back(length, index);
+            left -= length;
+        }
+    }
+
+    vector<ChunkTransactionLink> links;
+    if (valid) {
+        auto linkCount = reader.read<unsigned int>();
+        for (unsigned int i = 0; i < linkCount && !reader.isFailed(); i++) {
+            ChunkTransactionLink link;
+            link.x = reader.read<int>();
+            link.z = reader.read<int>();
+
+            auto elementCount = reader.read<unsigned int>();
+            for (unsigned int j = 0; j < elementCount && !reader.isFailed(); j++) {
+                link.elements.push_back(BlockTransactionElement(reader.readString()));
+            }
+            links.push_back(link);
+        }
+        valid = !reader.isFailed();
+    }
+
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    CloseHandle(file);
+
+    if (!valid) return false;
+
+    int baseX = C2G_COORD(world->getChunkPos()->x);
+    int baseZ = C2G_COORD(world->getChunkPos()->z);
+    size_t run = 0;
+
+    for (int column = 0; column < CHUNK_SIZE * CHUNK_SIZE; column++) {
+        int gx = baseX + column / CHUNK_SIZE;
+        int gz = baseZ + column % CHUNK_SIZE;
+
+        if (biomes[column] != nullptr) world->setBiomeAt(gx, gz, biomes[column]);
+
+        int y = WORLD_MIN_Y;
+        while (y <= heights[column]) {
+            Block const* block = palette[runs[run].second];
+            for (int i = 0; i < runs[run].first; i++, y++) world->setBlockAt(gx, y, gz, block);
+            run++;
+        }
+    }
+
+    for (auto& link: links) {
+        world->addOutgoingTransaction(link);
+        createTransactionCache(ChunkPos(link.x, link.z), link.elements);
+    }
+
+    return true;
+}
+
+void GEN_API::ChunkSnapshotCache::store(ChunkManager* world) {
+    std::unordered_map<Block const*, unsigned short> paletteIndex;
+    vector<Block const*> palette;
+    string body;
+
+    for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+        for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+            int height = world->getHighestBlockAt(lx, lz);
+            Block const* runBlock = nullptr;
+            unsigned short runLength = 0;
+
+            for (int y = WORLD_MIN_Y; y <= height; y++) {
+                Block const* block = &world->getBlockAt(lx, y, lz);
+                if (block == runBlock && runLength < 0xFFFF) {
+                    runLength++;
+                    continue;
+                }
+
+                if (runLength > 0) {
+                    writeValue(body, runLength);
+                    writeValue(body, paletteIndex[runBlock]);
+                }
+
+                if (paletteIndex.find(block) == paletteIndex.end()) {
+                    paletteIndex[block] = (unsigned short) palette.size();
+                    palette.push_back(block);
+                }
+                runBlock = block;
+                runLength = 1;
+            }
+
+            writeValue(body, runLength);
+            writeValue(body, paletteIndex[runBlock]);
+        }
+    }
+
+    //Палитра хранится парами (id, tileData). Если пара при чтении даст другое состояние блока, снимок не пишется
+    vector<BlockHandle> paletteHandles;
+    for (Block const* block: palette) {
+        BlockHandle handle = BlockRegistry::intern(block);
+        if (handle == BLOCK_HANDLE_INVALID || BlockRegistry::get(handle) != block) return;
+        paletteHandles.push_back(handle);
+    }
+
+    string snapshot;
+    writeValue(snapshot, (unsigned int) SNAPSHOT_MAGIC);
+    writeValue(snapshot, (unsigned short) SNAPSHOT_VERSION);
+
+    writeValue(snapshot, (unsigned short) palette.size());
+    for (BlockHandle handle: paletteHandles) {
+        writeString(snapshot, BlockRegistry::getName(handle));
+        writeValue(snapshot, BlockRegistry::getTileData(handle));
+    }
+
+    for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+        for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+            writeValue(snapshot, const_cast<Biome&>(world->getBiomeAt(lx, lz)).getId());
+        }
+    }
+
+    for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+        for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+            writeValue(snapshot, (short) world->getHighestBlockAt(lx, lz));
+        }
+    }
+
+    snapshot.append(body);
+
+    auto const& links = world->getOutgoingTransactions();
+    writeValue(snapshot, (unsigned int) links.size());
+    for (auto link: links) {
+        writeValue(snapshot, link.x);
+        writeValue(snapshot, link.z);
+        writeValue(snapshot, (unsigned int) link.elements.size());
+        for (auto& element: link.elements) writeString(snapshot, element.encode());
+    }
+
+    //Запись во временный файл и переименование, чтобы параллельное чтение не увидело недописанный снимок
+    std::filesystem::path path = getPath(world->getChunkPos());
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp" + to_string(GetCurrentThreadId());
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    out.write(snapshot.data(), (std::streamsize) snapshot.size());
+    out.close();
+
+    std::error_code error;
+    if (out.fail()) std::filesystem::remove(tmpPath, error);
+    else {
+        std::filesystem::rename(tmpPath, path, error);
+        if (error) std::filesystem::remove(tmpPath, error);
+    }
+}
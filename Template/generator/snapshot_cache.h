@@ -0,0 +1,31 @@
+#pragma once
+#include "pch.h"
+#include "generator_tools.h"
+
+
+#define SNAPSHOT_MAGIC 0x53475743
+#define SNAPSHOT_VERSION 1
+
+
+namespace GEN_API {
+    //Кэш результатов generateChunk для миров, которые часто пересоздаются с тем же сидом.
+    //Ключ - (id генератора, хеш параметров, сид, chunkX, chunkZ), каждый снимок - отдельный файл,
+    //который при чтении отображается в память. Сохраняются только блоки и биомы, установленные через ChunkManager
+    class ChunkSnapshotCache {
+    private:
+        std::filesystem::path directory;
+
+    public:
+        ChunkSnapshotCache(string const& rootPath, WorldGenerator* generator);
+
+        //Восстанавливает чанк из снимка. false - снимка нет или он поврежден
+        bool replay(ChunkManager* world);
+
+        //Сохраняет снимок только что сгенерированного чанка. Чанк с состоянием блока,
+        //которое не выражается парой (id, tileData), не сохраняется
+        void store(ChunkManager* world);
+
+    private:
+        std::filesystem::path getPath(ChunkPos const* chunkPos);
+    };
+}
@@ -0,0 +1,178 @@
+#include "spline.h"
+#include <stdexcept>
+
+
+GEN_API::Spline::Spline(int coordinate) {
+    if (coordinate < 0 || coordinate >= TERRAIN_SHAPER_MAX_DIMENSIONS) {
+        throw std::invalid_argument("Spline coordinate " + std::to_string(coordinate) + " is out of range");
+    }
+    this->coordinate = coordinate;
+}
+
+void GEN_API::Spline::checkLocation(float location) const {
+    if (!points.empty() && !(location > points.back().location)) {
+        throw std::invalid_argument("Spline points must be added in ascending location order");
+    }
+}
+
+void GEN_API::Spline::checkDimensions(int dimensions) const {
+    if (coordinate >= dimensions) {
+        throw std::invalid_argument("Spline depends on input " + std::to_string(coordinate) + " but only " +
+                                    std::to_string(dimensions) + " inputs are available");
+    }
+    for (Point const& point: points) {
+        if (point.nested != nullptr) point.nested->checkDimensions(dimensions);
+    }
+}
+
+float GEN_API::Spline::getValue(Point const& point, float const* inputs) {
+    return point.nested != nullptr? point.nested->evaluate(inputs) : point.value;
+}
+
+float GEN_API::Spline::evaluate(float const* inputs) const {
+    if (points.empty()) return 0.0f;
+
+    float x = inputs[coordinate];
+    Point const& first = points.front();
+    Point const& last = points.back();
+
+    if (x <= first.location) return getValue(first, inputs) + first.derivative * (x - first.location);
+    if (x >= last.location) return getValue(last, inputs) + last.derivative * (x - last.location);
+
+    size_t i = 0;
+    while (points[i + 1].location < x) i++;
+
+    Point const& left = points[i];
+    Point const& right = points[i + 1];
+    float width = right.location - left.location;
+    float t = (x - left.location) / width;
+
+    float v0 = getValue(left, inputs);
+    float v1 = getValue(right, inputs);
+    float a = left.derivative * width - (v1 - v0);
+    float b = -right.derivative * width + (v1 - v0);
+
+    return v0 + t * (v1 - v0) + t * (1.0f - t) * (a + t * (b - a));
+}
+
+GEN_API::TerrainShaper::TerrainShaper(Spline const* spline, int dimensions, int resolution, float minInput, float maxInput) {
+    if (dimensions < 1 || dimensions > TERRAIN_SHAPER_MAX_DIMENSIONS) {
+        throw std::invalid_argument("TerrainShaper supports 1 to " + std::to_string(TERRAIN_SHAPER_MAX_DIMENSIONS) + " dimensions");
+    }
+    spline->checkDimensions(dimensions);
+
+    this->dimensions = dimensions;
+    this->resolution = resolution < 2? 2 : resolution;
+    this->minInput = minInput;
+    this->scale = (this->resolution - 1) / (maxInput - minInput);
+
+    int sizeB = this->dimensions > 1? this->resolution : 1;
+    int sizeC = this->dimensions > 2? this->resolution : 1;
+    table.resize((size_t) this->resolution * sizeB * sizeC);
+
+    float step = (maxInput - minInput) / (this->resolution - 1);
+    float inputs[TERRAIN_SHAPER_MAX_DIMENSIONS] = {0.0f, 0.0f, 0.0f};
+    size_t index = 0;
+
+    for (int i = 0; i < this->resolution; i++) {
+        inputs[0] = minInput + i * step;
+        for (int j = 0; j < sizeB; j++) {
+            if (this->dimensions > 1) inputs[1] = minInput + j * step;
+            for (int k = 0; k < sizeC; k++) {
+                if (this->dimensions > 2) inputs[2] = minInput + k * step;
+                table[index++] = spline->evaluate(inputs);
+            }
+        }
+    }
+}
+
+void GEN_API::TerrainShaper::checkDimensions(int count) const {
+    if (count != dimensions) {
+        throw std::invalid_argument("TerrainShaper with " + std::to_string(dimensions) + " dimensions sampled with " +
+                                    std::to_string(count) + " inputs");
+    }
+}
+
+float GEN_API::TerrainShaper::sample(float a) const {
+    checkDimensions(1);
+    return interpolate(a);
+}
+
+float GEN_API::TerrainShaper::sample(float a, float b) const {
+    checkDimensions(2);
+    return interpolate(a, b);
+}
+
+float GEN_API::TerrainShaper::sample(float a, float b, float c) const {
+    checkDimensions(3);
+    return interpolate(a, b, c);
+}
+
+void GEN_API::TerrainShaper::sampleColumns(float const* a, float const* b, float const* c, float* out, int count) const {
+    int inputs = a == nullptr? 0 : (b == nullptr? 1 : (c == nullptr? 2 : 3));
+    checkDimensions(inputs < dimensions? inputs : dimensions);
+
+    float const* input[TERRAIN_SHAPER_MAX_DIMENSIONS] = {a, b, c};
+    size_t stride[TERRAIN_SHAPER_MAX_DIMENSIONS];
+    stride[dimensions - 1] = 1;
+    for (int d = dimensions - 2; d >= 0; d--) stride[d] = stride[d + 1] * resolution;
+
+    //Проверка один раз, дальше по блокам в два прохода: сначала индексы ячеек и веса (чистая арифметика,
+    //векторизуется), затем загрузки из таблицы и интерполяция
+    int offset[TERRAIN_SHAPER_BLOCK];
+    float t[TERRAIN_SHAPER_MAX_DIMENSIONS][TERRAIN_SHAPER_BLOCK];
+    float const* data = table.data();
+    float minimum = minInput;
+    float factor = scale;
+    float maxPosition = (float) (resolution - 1);
+    int maxIndex = resolution - 2;
+
+    for (int start = 0; start < count; start += TERRAIN_SHAPER_BLOCK) {
+        int size = std::min(count - start, TERRAIN_SHAPER_BLOCK);
+
+        for (int i = 0; i < size; i++) offset[i] = 0;
+        for (int d = 0; d < dimensions; d++) {
+            float const* values = input[d] + start;
+            float* weights = t[d];
+            int step = (int) stride[d];
+
+            for (int i = 0; i < size; i++) {
+                float position = std::min(std::max((values[i] - minimum) * factor, 0.0f), maxPosition);
+                int index = std::min((int) position, maxIndex);
+                weights[i] = position - (float) index;
+                offset[i] += index * step;
+            }
+        }
+
+        float* result = out + start;
+        if (dimensions == 1) {
+            for (int i = 0; i < size; i++) {
+                float const* cell = data + offset[i];
+                result[i] = cell[0] + (cell[1] - cell[0]) * t[0][i];
+            }
+        } else if (dimensions == 2) {
+            size_t strideA = stride[0];
+            for (int i = 0; i < size; i++) {
+                float const* cell = data + offset[i];
+                float v0 = cell[0] + (cell[1] - cell[0]) * t[1][i];
+                float v1 = cell[strideA] + (cell[strideA + 1] - cell[strideA]) * t[1][i];
+                result[i] = v0 + (v1 - v0) * t[0][i];
+            }
+        } else {
+            size_t strideA = stride[0];
+            size_t strideB = stride[1];
+            for (int i = 0; i < size; i++) {
+                float const* cell = data + offset[i];
+                float tc = t[2][i];
+                float v00 = cell[0] + (cell[1] - cell[0]) * tc;
+                float v01 = cell[strideB] + (cell[strideB + 1] - cell[strideB]) * tc;
+                float v10 = cell[strideA] + (cell[strideA + 1] - cell[strideA]) * tc;
+                float v11 = cell[strideA + strideB] + (cell[strideA + strideB + 1] - cell[strideA + strideB]) * tc;
+
+                float v0 = v00 + (v01 - v00) * t[1][i];
+                float v1 = v10 + (v11 - v10) * t[1][i];
+                result[i] = v0 + (v1 - v0) * t[0][i];
+            }
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+//Сплайны не зависят от SDK, как и noise.h, чтобы рельеф на TerrainShaper рисовался и утилитой Preview
+#include <vector>
+#include <string>
+#include <algorithm>
+
+
+#define TERRAIN_SHAPER_MAX_DIMENSIONS 3
+//Столбцов за один блок в sampleColumns
+#define TERRAIN_SHAPER_BLOCK 64
+
+
+namespace GEN_API {
+    //Кусочно-кубический (Эрмитов) сплайн по одному из входов (например 0 - continentalness, 1 - erosion, 2 - peaks).
+    //Значение в точке - константа или вложенный сплайн по другому входу
+    class Spline {
+    private:
+        struct Point {
+            float location;
+            float value;
+            Spline* nested;
+            float derivative;
+        };
+
+        int coordinate;
+        std::vector<Point> points;
+
+        static float getValue(Point const& point, float const* inputs);
+
+        void checkLocation(float location) const;
+
+    public:
+        //coordinate от 0 до TERRAIN_SHAPER_MAX_DIMENSIONS - 1, иначе std::invalid_argument
+        Spline(int coordinate);
+
+        //Вложенные сплайны принадлежат этому, копия удалила бы их повторно
+        Spline(Spline const&) = delete;
+
+        Spline& operator=(Spline const&) = delete;
+
+        ~Spline() {
+            for (Point& point: points) delete point.nested;
+        }
+
+        //Точки добавляются строго по возрастанию location, иначе std::invalid_argument
+        Spline* addPoint(float location, float value, float derivative = 0.0f) {
+            checkLocation(location);
+            points.push_back({location, value, nullptr, derivative});
+            return this;
+        }
+
+        Spline* addPoint(float location, Spline* value, float derivative = 0.0f) {
+            checkLocation(location);
+            points.push_back({location, 0.0f, value, derivative});
+            return this;
+        }
+
+        //std::invalid_argument, если этот или вложенный сплайн зависит от входа с номером >= dimensions
+        void checkDimensions(int dimensions) const;
+
+        float evaluate(float const* inputs) const;
+    };
+
+    //Сплайн, запеченный при создании в плотную таблицу resolution^dimensions значений на [minInput; maxInput].
+    //Выборка - несколько загрузок и линейная интерполяция, сложность сплайна на нее не влияет
+    class TerrainShaper {
+    private:
+        int dimensions;
+        int resolution;
+        float minInput;
+        float scale;
+        std::vector<float> table;
+
+        //Ячейка таблицы и вес по одному входу, вход зажимается в [minInput; maxInput]
+        void locate(float input, int& index, float& t) const {
+            float position = std::min(std::max((input - minInput) * scale, 0.0f), (float) (resolution - 1));
+            index = std::min((int) position, resolution - 2);
+            t = position - (float) index;
+        }
+
+        float interpolate(float a) const {
+            int i;
+            float ta;
+            locate(a, i, ta);
+
+            float const* row = table.data() + i;
+            return row[0] + (row[1] - row[0]) * ta;
+        }
+
+        float interpolate(float a, float b) const {
+            int i, j;
+            float ta, tb;
+            locate(a, i, ta);
+            locate(b, j, tb);
+
+            size_t strideA = resolution;
+            float const* cell = table.data() + i * strideA + j;
+
+            float v0 = cell[0] + (cell[1] - cell[0]) * tb;
+            float v1 = cell[strideA] + (cell[strideA + 1] - cell[strideA]) * tb;
+            return v0 + (v1 - v0) * ta;
+        }
+
+        float interpolate(float a, float b, float c) const {
+            int i, j, k;
+            float ta, tb, tc;
+            locate(a, i, ta);
+            locate(b, j, tb);
+            locate(c, k, tc);
+
+            size_t strideB = resolution;
+            size_t strideA = strideB * resolution;
+            float const* cell = table.data() + i * strideA + j * strideB + k;
+
+            float v00 = cell[0] + (cell[1] - cell[0]) * tc;
+            float v01 = cell[strideB] + (cell[strideB + 1] - cell[strideB]) * tc;
+            float v10 = cell[strideA] + (cell[strideA + 1] - cell[strideA]) * tc;
+            float v11 = cell[strideA + strideB] + (cell[strideA + strideB + 1] - cell[strideA + strideB]) * tc;
+
+            float v0 = v00 + (v01 - v00) * tb;
+            float v1 = v10 + (v11 - v10) * tb;
+            return v0 + (v1 - v0) * ta;
+        }
+
+        void checkDimensions(int count) const;
+
+    public:
+        //Сплайн должен зависеть только от входов 0..dimensions - 1, иначе std::invalid_argument
+        TerrainShaper(Spline const* spline, int dimensions, int resolution = 64, float minInput = -1.0f, float maxInput = 1.0f);
+
+        //Число аргументов должно совпадать с dimensions, иначе std::invalid_argument
+        float sample(float a) const;
+
+        float sample(float a, float b) const;
+
+        float sample(float a, float b, float c) const;
+
+        //Выборка для массива столбцов, например 256 столбцов чанка. Входы сверх dimensions могут быть nullptr
+        void sampleColumns(float const* a, float const* b, float const* c, float* out, int count) const;
+    };
+}
@@ -6,9 +6,11 @@
 #include <fstream>
 #include <utility>
 #include <filesystem>
+#include <functional>
 #include <Global.h>
 #include <EventAPI.h>
 #include <LoggerAPI.h>
+#include <ScheduleAPI.h>
 #include <MC/Level.hpp>
 #include <MC/Block.hpp>
 #include <MC/BlockSource.hpp>